@@ -15,7 +15,8 @@ struct QuickSQLiteBridge : jni::JavaClass<QuickSQLiteBridge> {
         {// initialization for JSI
          makeNativeMethod("installNativeJsi",
                           QuickSQLiteBridge::installNativeJsi),
-         {"clearStateNativeJsi", "()V", (void*)&QuickSQLiteBridge::clearStateNativeJsi}     
+         {"clearStateNativeJsi", "()V", (void*)&QuickSQLiteBridge::clearStateNativeJsi},
+         {"releaseMemoryNativeJsi", "()V", (void*)&QuickSQLiteBridge::releaseMemoryNativeJsi}
     });
   }
 
@@ -34,6 +35,10 @@ private:
   static void clearStateNativeJsi() {
     osp::clearState();
   }
+
+  static void releaseMemoryNativeJsi() {
+    osp::releaseMemory();
+  }
 };
 
 JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *) {
@@ -9,6 +9,7 @@ import com.facebook.react.turbomodule.core.CallInvokerHolderImpl;
 public class QuickSQLiteBridge {
   private native void installNativeJsi(long jsContextNativePointer, CallInvokerHolderImpl jsCallInvokerHolder, String docPath);
   private native void clearStateNativeJsi();
+  private native void releaseMemoryNativeJsi();
   public static final QuickSQLiteBridge instance = new QuickSQLiteBridge();
 
   public void install(ReactContext context) {
@@ -26,4 +27,8 @@ public class QuickSQLiteBridge {
   public void clearState() {
     clearStateNativeJsi();
   }
+
+  public void releaseMemory() {
+    releaseMemoryNativeJsi();
+  }
 }
@@ -1,6 +1,8 @@
 package com.reactnativequicksqlite;
 
 import androidx.annotation.NonNull;
+import android.content.ComponentCallbacks2;
+import android.content.res.Configuration;
 import android.util.Log;
 
 import com.facebook.jni.HybridData;
@@ -13,8 +15,29 @@ import com.facebook.react.turbomodule.core.CallInvokerHolderImpl;
 class SequelModule extends ReactContextBaseJavaModule {
   public static final String NAME = "QuickSQLite";
   
+  private boolean isInstalled = false;
+
+  // Releases memory of the open databases when the system is low on memory
+  private final ComponentCallbacks2 memoryCallbacks = new ComponentCallbacks2() {
+    @Override
+    public void onTrimMemory(int level) {
+      if (isInstalled && level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW) {
+        QuickSQLiteBridge.instance.releaseMemory();
+      }
+    }
+
+    @Override
+    public void onConfigurationChanged(@NonNull Configuration configuration) {}
+
+    @Override
+    public void onLowMemory() {
+      onTrimMemory(ComponentCallbacks2.TRIM_MEMORY_COMPLETE);
+    }
+  };
+
   public SequelModule(ReactApplicationContext context) {
     super(context);
+    context.getApplicationContext().registerComponentCallbacks(memoryCallbacks);
   }
 
   @NonNull
@@ -28,6 +51,7 @@ class SequelModule extends ReactContextBaseJavaModule {
     try {
       System.loadLibrary("react-native-quick-sqlite");
       QuickSQLiteBridge.instance.install(getReactApplicationContext());
+      isInstalled = true;
       return true;
     } catch (Exception exception) {
       Log.e(NAME, "Failed to install JSI Bindings!", exception);
@@ -37,6 +61,7 @@ class SequelModule extends ReactContextBaseJavaModule {
 
   @Override
   public void onCatalystInstanceDestroy() {
+    getReactApplicationContext().getApplicationContext().unregisterComponentCallbacks(memoryCallbacks);
     try {
       QuickSQLiteBridge.instance.clearState();
     } catch (Exception exception) {
@@ -3,33 +3,83 @@
 #include "sqlite3.h"
 #include "sqliteBridge.h"
 #include "sqliteExecute.h"
+#include <cstring>
+
+static int mutexFlag(ConnectionOptions const &options) {
+  return options.noMutex ? SQLITE_OPEN_NOMUTEX : SQLITE_OPEN_FULLMUTEX;
+}
+
+/**
+ * Applies the pragmas which were set in the options
+ */
+static void applyConnectionOptions(sqlite3 *db,
+                                   ConnectionOptions const &options) {
+  if (options.cacheSize.has_value()) {
+    sqliteExecuteLiteralWithDB(db, "PRAGMA cache_size = " +
+                                       std::to_string(*options.cacheSize));
+  }
+  if (options.mmapSize.has_value()) {
+    sqliteExecuteLiteralWithDB(db, "PRAGMA mmap_size = " +
+                                       std::to_string(*options.mmapSize));
+  }
+  if (options.walAutocheckpoint.has_value()) {
+    sqliteExecuteLiteralWithDB(db,
+                               "PRAGMA wal_autocheckpoint = " +
+                                   std::to_string(*options.walAutocheckpoint));
+  }
+  if (options.tempStore.has_value()) {
+    sqliteExecuteLiteralWithDB(db, "PRAGMA temp_store = " +
+                                       std::to_string(*options.tempStore));
+  }
+  if (options.busyTimeout.has_value()) {
+    sqlite3_busy_timeout(db, *options.busyTimeout);
+  }
+}
 
 ConnectionPool::ConnectionPool(std::string dbName, std::string docPath,
-                               unsigned int numReadConnections)
-    : dbName(dbName), maxReads(numReadConnections),
+                               unsigned int numReadConnections,
+                               ConnectionOptions const &options)
+    : dbName(dbName), docPath(docPath), maxReads(numReadConnections),
       writeConnection(dbName, docPath,
                       SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE |
-                          SQLITE_OPEN_FULLMUTEX),
+                          mutexFlag(options),
+                      options.sharedWorkers),
       commitPayload(
           {.dbName = &this->dbName, .event = TransactionEvent::COMMIT}),
       rollbackPayload({
           .dbName = &this->dbName,
           .event = TransactionEvent::ROLLBACK,
-      }) {
+      }),
+      options(options) {
 
   onContextCallback = nullptr;
+  onTransactionFinalizedCallback = nullptr;
+  onTransactionCommittedCallback = nullptr;
+  lastUpdateIndex = 0;
+  nextTaskContextId = 0;
   isConcurrencyEnabled = maxReads > 0;
+  writeConnection.int64Results = options.int64Results;
+
+  statsEnabled = false;
+  profileStatements = false;
 
   readConnections = new ConnectionState *[maxReads];
-  // Open the read connections
+  // Open the read connections, lazy connections are opened once needed
   for (int i = 0; i < maxReads; i++) {
-    readConnections[i] = new ConnectionState(
-        dbName, docPath, SQLITE_OPEN_READONLY | SQLITE_OPEN_FULLMUTEX);
+    readConnections[i] =
+        options.lazyReadConnections ? nullptr : openReadConnection();
+  }
+  // Connections are taken from the back, prefer the first connections
+  for (int i = maxReads - 1; i >= 0; i--) {
+    if (readConnections[i] != nullptr) {
+      availableReadConnections.push_back(readConnections[i]);
+    }
   }
 
   if (true == isConcurrencyEnabled) {
     // Write connection WAL setup
-    writeConnection.queueWork([](sqlite3 *db) {
+    writeConnection.queueWork([](ConnectionState *state) {
+      sqlite3 *db = state->connection;
       sqliteExecuteLiteralWithDB(db, "PRAGMA journal_mode = WAL;");
       sqliteExecuteLiteralWithDB(
           db,
@@ -38,13 +88,25 @@ ConnectionPool::ConnectionPool(std::string dbName, std::string docPath,
       // Default to normal on all connections
       sqliteExecuteLiteralWithDB(db, "PRAGMA synchronous = NORMAL;");
     });
+  }
 
-    // Read connections WAL setup
-    for (int i = 0; i < this->maxReads; i++) {
-      readConnections[i]->queueWork([](sqlite3 *db) {
-        sqliteExecuteLiteralWithDB(db, "PRAGMA synchronous = NORMAL;");
-      });
-    }
+  // Read connections apply the options when they are opened
+  writeConnection.queueWork([options](ConnectionState *state) {
+    applyConnectionOptions(state->connection, options);
+  });
+
+  if (isConcurrencyEnabled && options.backgroundCheckpoints) {
+    // Defaults to the SQLite autocheckpoint threshold
+    checkpointScheduler.enable(options.walAutocheckpoint.value_or(1000),
+                               options.busyTimeout.value_or(0));
+    // Registered after the pragmas, the WAL hook replaces the inline
+    // autocheckpoints
+    writeConnection.queueWork([this](ConnectionState *state) {
+      sqlite3_wal_hook(state->connection,
+                       (int (*)(void *, sqlite3 *, const char *,
+                                int))onWalCommitIntermediate,
+                       (void *)this);
+    });
   }
 };
 
@@ -56,56 +118,35 @@ ConnectionPool::~ConnectionPool() {
 }
 
 void ConnectionPool::readLock(ConnectionLockId contextId) {
-  // Maintain compatibility if no concurrent read connections are present
-  if (false == isConcurrencyEnabled) {
-    return writeLock(contextId);
-  }
-
-  // Check if there are any available read connections
-  if (readQueue.size() > 0) {
-    // There are already items queued
-    readQueue.push_back(contextId);
-  } else {
-    // Check if there are open slots
-    for (int i = 0; i < maxReads; i++) {
-      if (readConnections[i]->isEmptyLock()) {
-        // There is an open slot
-        activateContext(*readConnections[i], contextId);
-        return;
-      }
-    }
-
-    // If we made it here, there were no open slots, need to queue
-    readQueue.push_back(contextId);
-  }
+  requestReadLock(LockRequest{.contextId = contextId});
 }
 
 void ConnectionPool::writeLock(ConnectionLockId contextId) {
-  // Check if there are any available read connections
-  if (writeConnection.isEmptyLock()) {
-    activateContext(writeConnection, contextId);
-    return;
-  }
+  requestWriteLock(LockRequest{.contextId = contextId});
+}
 
-  // If we made it here, there were no open slots, need to queue
-  writeQueue.push_back(contextId);
+void ConnectionPool::executeWithReadLock(ConnectionTask task,
+                                         TaskRejection reject) {
+  requestReadLock(LockRequest{.contextId = generateTaskContextId(),
+                              .task = std::move(task),
+                              .reject = std::move(reject)});
+}
+
+void ConnectionPool::executeWithWriteLock(ConnectionTask task,
+                                          TaskRejection reject) {
+  requestWriteLock(LockRequest{.contextId = generateTaskContextId(),
+                               .task = std::move(task),
+                               .reject = std::move(reject)});
 }
 
-SQLiteOPResult
-ConnectionPool::queueInContext(ConnectionLockId contextId,
-                               std::function<void(sqlite3 *)> task) {
+SQLiteOPResult ConnectionPool::queueInContext(ConnectionLockId contextId,
+                                              ConnectionTask task) {
   ConnectionState *state = nullptr;
-  if (writeConnection.matchesLock(contextId)) {
-    state = &writeConnection;
-  } else {
-    // Check if it's a read connection
-    for (int i = 0; i < maxReads; i++) {
-      if (readConnections[i]->matchesLock(contextId)) {
-        state = readConnections[i];
-        break;
-      }
-    }
+  {
+    std::lock_guard<std::mutex> lock(contextMutex);
+    state = findContext(contextId);
   }
+
   if (state == nullptr) {
     // return error that context is not available
     return SQLiteOPResult{
@@ -114,7 +155,12 @@ ConnectionPool::queueInContext(ConnectionLockId contextId,
     };
   }
 
-  state->queueWork(task);
+  if (!state->queueWork(std::move(task))) {
+    return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "Connection is closed",
+    };
+  }
 
   return SQLiteOPResult{
       .type = SQLiteOk,
@@ -126,11 +172,42 @@ void ConnectionPool::setOnContextAvailable(void (*callback)(std::string,
   onContextCallback = callback;
 }
 
-void ConnectionPool::setTableUpdateHandler(
-    void (*callback)(void *, int, const char *, const char *, sqlite3_int64)) {
-  // Only the write connection can make changes
-  sqlite3_update_hook(writeConnection.connection, callback,
-                      (void *)(dbName.c_str()));
+/**
+ * Collects table changes on the write connection. Changes are grouped by
+ * table and operation type, consecutive changes typically affect the same
+ * group.
+ */
+void onUpdateIntermediate(ConnectionPool *pool, int opType, const char *dbName,
+                          const char *tableName, sqlite3_int64 rowId) {
+  auto &updates = pool->pendingUpdates;
+  TableUpdates *group = nullptr;
+
+  if (pool->lastUpdateIndex < updates.size()) {
+    auto &last = updates[pool->lastUpdateIndex];
+    if (last.opType == opType && last.table == tableName) {
+      group = &last;
+    }
+  }
+
+  if (group == nullptr) {
+    for (size_t i = 0; i < updates.size(); i++) {
+      if (updates[i].opType == opType && updates[i].table == tableName) {
+        group = &updates[i];
+        pool->lastUpdateIndex = i;
+        break;
+      }
+    }
+  }
+
+  if (group == nullptr) {
+    updates.push_back(TableUpdates{.table = tableName, .opType = opType});
+    pool->lastUpdateIndex = updates.size() - 1;
+    group = &updates.back();
+  }
+
+  if (pool->options.reportRowIds) {
+    group->rowIds.push_back(rowId);
+  }
 }
 
 /**
@@ -138,53 +215,141 @@ void ConnectionPool::setTableUpdateHandler(
  * proceed correctly
  */
 int onCommitIntermediate(ConnectionPool *pool) {
-  if (pool->onCommitCallback != NULL) {
-    pool->onCommitCallback(&(pool->commitPayload));
+  auto updates = std::make_shared<std::vector<TableUpdates>>(
+      std::move(pool->pendingUpdates));
+  pool->pendingUpdates.clear();
+  pool->lastUpdateIndex = 0;
+
+  if (pool->onTransactionFinalizedCallback != NULL) {
+    pool->onTransactionFinalizedCallback(&(pool->commitPayload), updates);
+  }
+  if (pool->onTransactionCommittedCallback != NULL && !updates->empty()) {
+    // The hook runs before the commit completed, read connections could still
+    // see the previous snapshot. Queued work runs after the current statement.
+    pool->writeConnection.queueWork([pool, updates](ConnectionState *state) {
+      pool->onTransactionCommittedCallback(&(pool->commitPayload), updates);
+    });
   }
   return 0;
 }
 
+void onRollbackIntermediate(ConnectionPool *pool) {
+  // Changes which were rolled back are never reported
+  pool->pendingUpdates.clear();
+  pool->lastUpdateIndex = 0;
+
+  if (pool->onTransactionFinalizedCallback != NULL) {
+    pool->onTransactionFinalizedCallback(&(pool->rollbackPayload), nullptr);
+  }
+}
+
+int onWalCommitIntermediate(ConnectionPool *pool, sqlite3 *db,
+                            const char *dbName, int frames) {
+  // Only the main database is checkpointed
+  if (strcmp(dbName, "main") == 0) {
+    pool->checkpointScheduler.onWalCommit(frames);
+  }
+  return SQLITE_OK;
+}
+
 void ConnectionPool::setTransactionFinalizerHandler(
-    void (*callback)(const TransactionCallbackPayload *)) {
-  this->onCommitCallback = callback;
-  sqlite3_commit_hook(writeConnection.connection,
-                      (int (*)(void *))onCommitIntermediate, (void *)this);
-  sqlite3_rollback_hook(writeConnection.connection, (void (*)(void *))callback,
-                        (void *)&rollbackPayload);
+    TransactionFinalizerCallback callback) {
+  this->onTransactionFinalizedCallback = callback;
+  // Only the write connection can make changes. The hooks are registered on
+  // its worker thread, connections opened with noMutex must not be used
+  // concurrently.
+  writeConnection.queueWork([this](ConnectionState *state) {
+    sqlite3_update_hook(state->connection,
+                        (void (*)(void *, int, const char *, const char *,
+                                  sqlite3_int64))onUpdateIntermediate,
+                        (void *)this);
+    sqlite3_commit_hook(state->connection,
+                        (int (*)(void *))onCommitIntermediate, (void *)this);
+    sqlite3_rollback_hook(state->connection,
+                          (void (*)(void *))onRollbackIntermediate,
+                          (void *)this);
+  });
+}
+
+void ConnectionPool::setTransactionCommittedHandler(
+    TransactionFinalizerCallback callback) {
+  this->onTransactionCommittedCallback = callback;
 }
 
 void ConnectionPool::closeContext(ConnectionLockId contextId) {
-  if (writeConnection.matchesLock(contextId)) {
-    if (writeQueue.size() > 0) {
-      // There are items in the queue, activate the next one
-      activateContext(writeConnection, writeQueue[0]);
-      writeQueue.erase(writeQueue.begin());
-    } else {
-      // No items in the queue, clear the context
-      writeConnection.clearLock();
-    }
-  } else {
-    // Check if it's a read connection
-    for (int i = 0; i < maxReads; i++) {
-      if (readConnections[i]->matchesLock(contextId)) {
-        if (readQueue.size() > 0) {
-          // There are items in the queue, activate the next one
-          activateContext(*readConnections[i], readQueue[0]);
-          readQueue.erase(readQueue.begin());
-        } else {
-          // No items in the queue, clear the context
-          readConnections[i]->clearLock();
-        }
-        return;
-      }
+  std::lock_guard<std::mutex> lock(contextMutex);
+  auto state = findContext(contextId);
+  if (state == nullptr) {
+    return;
+  }
+
+  activeContexts.erase(contextId);
+  closeCursors(*state);
+
+  bool isWriteConnection = state == &writeConnection;
+  auto &queue = isWriteConnection ? writeQueue : readQueue;
+  // Checkpoints wait for the write connection to be idle, unless the WAL keeps
+  // growing because writers are always queued
+  if (isWriteConnection &&
+      (queue.empty() || checkpointScheduler.isOverdue()) &&
+      checkpointScheduler.takePending()) {
+    // The next writer is activated once the checkpoint completed
+    auto checkpoint = LockRequest{
+        .contextId = generateTaskContextId(),
+        .task =
+            [this](ConnectionState *state) {
+              checkpointScheduler.checkpoint(state->connection);
+            },
+    };
+    activateContext(*state, checkpoint);
+    return;
+  }
+
+  while (!queue.empty()) {
+    // There are items in the queue, activate the next one. Tasks are only
+    // dropped while the connection is closing.
+    auto nextRequest = std::move(queue.front());
+    queue.pop_front();
+    if (activateContext(*state, nextRequest)) {
+      return;
     }
   }
+
+  // No items in the queue, clear the context
+  state->clearLock();
+  if (!isWriteConnection) {
+    availableReadConnections.push_back(state);
+  }
 }
 
 void ConnectionPool::closeAll() {
-  writeConnection.close();
-  for (int i = 0; i < maxReads; i++) {
-    readConnections[i]->close();
+  auto connections = getAllConnections();
+  // Completed tasks can activate queued native tasks on another connection.
+  // Drain all connections before closing any of them.
+  bool isDrained = false;
+  while (!isDrained) {
+    for (auto state : connections) {
+      state->waitFinished();
+    }
+    isDrained = true;
+    for (auto state : connections) {
+      isDrained = isDrained && state->isIdle();
+    }
+  }
+
+  for (auto state : connections) {
+    state->close();
+  }
+
+  // Native tasks still waiting for a lock held by JS never run
+  std::lock_guard<std::mutex> lock(contextMutex);
+  for (auto queue : {&readQueue, &writeQueue}) {
+    for (auto &request : *queue) {
+      if (request.reject) {
+        request.reject("Connection is closed");
+      }
+    }
+    queue->clear();
   }
 }
 
@@ -199,22 +364,23 @@ SQLiteOPResult ConnectionPool::attachDatabase(std::string const dbFileName,
   string dbPath = get_db_path(dbFileName, docPath);
   string statement = "ATTACH DATABASE '" + dbPath + "' AS " + alias;
 
-  auto dbConnections = getAllConnections();
-
-  for (auto &connectionState : dbConnections) {
-    if (!connectionState->isEmptyLock()) {
-      return SQLiteOPResult{
-          .type = SQLiteError,
-          .errorMessage = dbName + " was unable to attach another database: " +
-                          "Some DB connections were locked",
-      };
-    }
+  std::unique_lock<std::mutex> lock(contextMutex);
+  if (isLocked()) {
+    return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = dbName + " was unable to attach another database: " +
+                        "Some DB connections were locked",
+    };
   }
 
-  for (auto &connectionState : dbConnections) {
-    SequelLiteralUpdateResult result =
-        sqliteExecuteLiteralWithDB(connectionState->connection, statement);
+  // Read connections which are opened later attach the database as well
+  attachStatements.push_back(std::make_pair(alias, statement));
+
+  for (auto &result : executeOnConnections(statement, lock)) {
     if (result.type == SQLiteError) {
+      lock.lock();
+      eraseAttachStatement(alias);
+      lock.unlock();
       // Revert change on any successful connections
       detachDatabase(alias);
       return SQLiteOPResult{
@@ -236,50 +402,298 @@ SQLiteOPResult ConnectionPool::detachDatabase(std::string const alias) {
    * sqliteExecuteLiteral will do that.
    * */
   string statement = "DETACH DATABASE " + alias;
-  auto dbConnections = getAllConnections();
 
-  for (auto &connectionState : dbConnections) {
-    if (!connectionState->isEmptyLock()) {
-      return SQLiteOPResult{
-          .type = SQLiteError,
-          .errorMessage = dbName + " was unable to detach another database: " +
-                          "Some DB connections were locked",
-      };
-    }
+  std::unique_lock<std::mutex> lock(contextMutex);
+  if (isLocked()) {
+    return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = dbName + " was unable to detach another database: " +
+                        "Some DB connections were locked",
+    };
   }
 
-  for (auto &connectionState : dbConnections) {
-    SequelLiteralUpdateResult result =
-        sqliteExecuteLiteralWithDB(connectionState->connection, statement);
+  for (auto &result : executeOnConnections(statement, lock)) {
     if (result.type == SQLiteError) {
       return SQLiteOPResult{
           .type = SQLiteError,
-          .errorMessage = dbName + " was unable to attach another database: " +
+          .errorMessage = dbName + " was unable to detach another database: " +
                           string(result.message),
       };
     }
   }
+
+  // Kept for read connections opened later if the statement failed
+  lock.lock();
+  eraseAttachStatement(alias);
   return SQLiteOPResult{
       .type = SQLiteOk,
   };
 }
 
+void ConnectionPool::setStatsEnabled(bool enabled, bool profileStatements) {
+  this->statsEnabled = enabled;
+  this->profileStatements = profileStatements;
+  for (auto &connectionState : getAllConnections()) {
+    connectionState->stats->setEnabled(enabled, profileStatements);
+    // The profiling callback is registered on the worker thread
+    connectionState->queueWork([](ConnectionState *state) {
+      state->stats->applyProfiling();
+    });
+  }
+}
+
+std::vector<ConnectionStatsSnapshot> ConnectionPool::getStats(bool reset) {
+  std::vector<ConnectionStatsSnapshot> result;
+  for (auto &connectionState : getAllConnections()) {
+    auto snapshot = connectionState->stats->snapshot();
+    snapshot.statementCacheHits = connectionState->statementCache.getHits();
+    snapshot.statementCacheMisses =
+        connectionState->statementCache.getMisses();
+    if (reset) {
+      connectionState->stats->reset();
+    }
+    result.push_back(std::move(snapshot));
+  }
+  return result;
+}
+
+void ConnectionPool::requestCheckpoint(bool truncate) {
+  if (!checkpointScheduler.isEnabled()) {
+    return;
+  }
+  checkpointScheduler.request(truncate);
+  // Releasing any active write lock runs the checkpoint as well, whichever
+  // happens first takes the pending checkpoint
+  executeWithWriteLock([this](ConnectionState *state) {
+    if (checkpointScheduler.takePending()) {
+      checkpointScheduler.checkpoint(state->connection);
+    }
+  });
+}
+
+CheckpointStatsSnapshot ConnectionPool::getCheckpointStats() {
+  return checkpointScheduler.snapshot();
+}
+
+void ConnectionPool::interruptContext(ConnectionLockId contextId) {
+  std::lock_guard<std::mutex> lock(contextMutex);
+  ConnectionState *state = findContext(contextId);
+  if (state != nullptr) {
+    // Safe to call from any thread, without effect if no statement is running
+    sqlite3_interrupt(state->connection);
+  }
+}
+
+void ConnectionPool::interruptAll() {
+  for (auto &connectionState : getAllConnections()) {
+    sqlite3_interrupt(connectionState->connection);
+  }
+}
+
+void ConnectionPool::releaseMemory() {
+  std::vector<ConnectionState *> idleConnections;
+  if (options.lazyReadConnections) {
+    std::lock_guard<std::mutex> lock(contextMutex);
+    // Available connections are not locked to a context, they can't be used
+    // once they are removed
+    for (auto state : availableReadConnections) {
+      for (int i = 0; i < maxReads; i++) {
+        if (readConnections[i] == state) {
+          readConnections[i] = nullptr;
+        }
+      }
+      idleConnections.push_back(state);
+    }
+    availableReadConnections.clear();
+  }
+
+  for (auto state : idleConnections) {
+    state->close();
+    delete state;
+  }
+
+  // Connections in use release their cache in between tasks
+  for (auto state : getAllConnections()) {
+    state->queueWork([](ConnectionState *state) {
+      sqlite3_db_release_memory(state->connection);
+    });
+  }
+}
+
 // ===================== Private ===============
 
 std::vector<ConnectionState *> ConnectionPool::getAllConnections() {
   std::vector<ConnectionState *> result;
   result.push_back(&writeConnection);
   for (int i = 0; i < maxReads; i++) {
-    result.push_back(readConnections[i]);
+    if (readConnections[i] != nullptr) {
+      result.push_back(readConnections[i]);
+    }
   }
   return result;
 }
 
-void ConnectionPool::activateContext(ConnectionState &state,
-                                     ConnectionLockId contextId) {
+ConnectionState *ConnectionPool::openReadConnection() {
+  auto state =
+      new ConnectionState(dbName, docPath,
+                          SQLITE_OPEN_READONLY | mutexFlag(options),
+                          options.sharedWorkers);
+  state->int64Results = options.int64Results;
+  state->stats->setEnabled(statsEnabled, profileStatements);
+  state->queueWork(
+      [](ConnectionState *state) { state->stats->applyProfiling(); });
+  if (options.readThreadIdleTimeoutMs.has_value()) {
+    state->setIdleTimeout(
+        std::chrono::milliseconds(*options.readThreadIdleTimeoutMs));
+  }
+
+  auto options = this->options;
+  auto attachStatements = this->attachStatements;
+  state->queueWork([options, attachStatements](ConnectionState *state) {
+    sqlite3 *db = state->connection;
+    // The write connection enables WAL mode for the database
+    sqliteExecuteLiteralWithDB(db, "PRAGMA synchronous = NORMAL;");
+    applyConnectionOptions(db, options);
+    for (auto &attach : attachStatements) {
+      sqliteExecuteLiteralWithDB(db, attach.second);
+    }
+  });
+  return state;
+}
+
+std::vector<SequelLiteralUpdateResult> ConnectionPool::executeOnConnections(
+    std::string const &statement, std::unique_lock<std::mutex> &lock) {
+  auto connections = getAllConnections();
+  // Kept if the task is dropped because the connection is closing
+  auto closedResult = SequelLiteralUpdateResult{
+      .type = SQLiteError,
+      .message = "Connection is closed",
+  };
+  std::vector<SequelLiteralUpdateResult> results(connections.size(),
+                                                 closedResult);
+  for (size_t i = 0; i < connections.size(); i++) {
+    // Unlocked connections can still run native tasks or release memory when
+    // idle, the statement has to run on the worker thread as well
+    connections[i]->queueWork([&results, i, statement](ConnectionState *state) {
+      // Cached statements could reference the previous set of databases
+      state->statementCache.clear();
+      results[i] = sqliteExecuteLiteralWithDB(state->connection, statement);
+    });
+  }
+  // Tasks of contexts activated from here on are queued after the statement.
+  // Completed tasks close their context, which needs the mutex.
+  lock.unlock();
+  for (auto state : connections) {
+    state->waitFinished();
+  }
+  return results;
+}
+
+bool ConnectionPool::isLocked() {
+  return !activeContexts.empty() || !readQueue.empty() || !writeQueue.empty();
+}
+
+void ConnectionPool::eraseAttachStatement(std::string const &alias) {
+  for (auto it = attachStatements.begin(); it != attachStatements.end(); it++) {
+    if (it->first == alias) {
+      attachStatements.erase(it);
+      break;
+    }
+  }
+}
+
+void ConnectionPool::ensureAvailableReadConnection() {
+  if (!availableReadConnections.empty()) {
+    return;
+  }
+  for (int i = 0; i < maxReads; i++) {
+    if (readConnections[i] == nullptr) {
+      readConnections[i] = openReadConnection();
+      availableReadConnections.push_back(readConnections[i]);
+      return;
+    }
+  }
+}
+
+void ConnectionPool::closeCursors(ConnectionState &state) {
+  // Cursors are scoped to a lock context, they should not keep statements
+  // (and their read transactions) alive once the lock is released.
+  if (state.hasOpenCursors()) {
+    state.queueWork([](ConnectionState *state) { state->closeAllCursors(); });
+  }
+}
+
+ConnectionState *
+ConnectionPool::findContext(const ConnectionLockId &contextId) {
+  auto context = activeContexts.find(contextId);
+  return context == activeContexts.end() ? nullptr : context->second;
+}
+
+void ConnectionPool::requestReadLock(LockRequest request) {
+  // Maintain compatibility if no concurrent read connections are present
+  if (false == isConcurrencyEnabled) {
+    return requestWriteLock(std::move(request));
+  }
+
+  std::lock_guard<std::mutex> lock(contextMutex);
+  if (options.lazyReadConnections) {
+    ensureAvailableReadConnection();
+  }
+  // Queued items take precedence over any open slots
+  if (readQueue.empty() && !availableReadConnections.empty()) {
+    auto state = availableReadConnections.back();
+    availableReadConnections.pop_back();
+    activateContext(*state, request);
+    return;
+  }
+
+  // If we made it here, there were no open slots, need to queue
+  readQueue.push_back(std::move(request));
+}
+
+void ConnectionPool::requestWriteLock(LockRequest request) {
+  std::lock_guard<std::mutex> lock(contextMutex);
+  // Check if the write connection is available
+  if (writeConnection.isEmptyLock()) {
+    activateContext(writeConnection, request);
+    return;
+  }
+
+  // If we made it here, there were no open slots, need to queue
+  writeQueue.push_back(std::move(request));
+}
+
+ConnectionLockId ConnectionPool::generateTaskContextId() {
+  // JS generates numeric IDs, the prefix avoids any collisions
+  return "native:" + std::to_string(++nextTaskContextId);
+}
+
+bool ConnectionPool::activateContext(ConnectionState &state,
+                                     LockRequest &request) {
+  auto contextId = request.contextId;
   state.activateLock(contextId);
+  activeContexts[contextId] = &state;
+
+  if (request.task) {
+    // Nothing else can use this context, release it once the task is done
+    bool isQueued = state.queueWork(std::move(request.task),
+                                    [this, contextId](ConnectionState *state) {
+                                      closeContext(contextId);
+                                    });
+    if (!isQueued) {
+      activeContexts.erase(contextId);
+      state.clearLock();
+      if (request.reject) {
+        request.reject("Connection is closed");
+      }
+    }
+    return isQueued;
+  }
 
+  // This is called with the context mutex held. The callback should only
+  // schedule work, it must not request or release locks synchronously.
   if (onContextCallback != nullptr) {
     onContextCallback(dbName, contextId);
   }
+  return true;
 }
@@ -1,7 +1,14 @@
 #include "ConnectionState.h"
 #include "JSIHelper.h"
+#include "WalCheckpointScheduler.h"
 #include "sqlite3.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #ifndef ConnectionPool_h
@@ -14,6 +21,86 @@ struct TransactionCallbackPayload {
   TransactionEvent event;
 };
 
+/**
+ * Values for PRAGMA temp_store
+ */
+enum TempStore {
+  TEMP_STORE_DEFAULT = 0,
+  TEMP_STORE_FILE = 1,
+  TEMP_STORE_MEMORY = 2
+};
+
+/**
+ * Options provided when a database is opened. Pragmas which are not set keep
+ * the SQLite defaults and are applied to the write and read connections alike.
+ */
+struct ConnectionOptions {
+  // Report the row ID of each changed row in table updates
+  bool reportRowIds = true;
+  // Read integer results as 64 bit values
+  bool int64Results = false;
+  // Open the connections with SQLITE_OPEN_NOMUTEX instead of
+  // SQLITE_OPEN_FULLMUTEX. Each connection is only used by one thread at a
+  // time, its worker thread.
+  bool noMutex = false;
+
+  // PRAGMA cache_size, pages if positive or KiB if negative
+  std::optional<long long> cacheSize;
+  // PRAGMA mmap_size in bytes
+  std::optional<long long> mmapSize;
+  // PRAGMA wal_autocheckpoint in pages. This is the checkpoint threshold of
+  // the background checkpoints if they are enabled.
+  std::optional<long long> walAutocheckpoint;
+  // Checkpoint the WAL while the write connection is idle instead of inline
+  // with commits. Only applies if read connections are used.
+  bool backgroundCheckpoints = false;
+  std::optional<TempStore> tempStore;
+  // sqlite3_busy_timeout in milliseconds
+  std::optional<int> busyTimeout;
+  // Idle time after which the worker thread of a read connection exits. The
+  // thread is restarted for the next read.
+  std::optional<int> readThreadIdleTimeoutMs;
+  // Open read connections once all open ones are in use instead of opening
+  // all of them with the pool. Idle read connections are closed again when
+  // memory is released.
+  bool lazyReadConnections = false;
+  // Run the tasks of all connections on the shared worker pool instead of a
+  // thread per connection
+  bool sharedWorkers = false;
+};
+
+/**
+ * Called with an error message if a task can't run because its connections
+ * are closing. Can be called from any thread.
+ */
+typedef std::function<void(std::string const &)> TaskRejection;
+
+/**
+ * A queued request for a lock context. Requests made from JS are notified once
+ * the context is active. Requests with a task run the task as soon as the
+ * context is active and release it once the task completes.
+ */
+struct LockRequest {
+  ConnectionLockId contextId;
+  ConnectionTask task;
+  // Called instead of the task if it is dropped
+  TaskRejection reject;
+};
+
+/**
+ * Changes made to a table with a single operation type during a transaction
+ */
+struct TableUpdates {
+  std::string table;
+  int opType;
+  // Only collected if row IDs are reported
+  std::vector<sqlite3_int64> rowIds;
+};
+
+typedef void (*TransactionFinalizerCallback)(
+    const TransactionCallbackPayload *,
+    std::shared_ptr<std::vector<TableUpdates>> updates);
+
 // The number of concurrent read connections to the database.
 /**
  * Concurrent connection pool class.
@@ -28,9 +115,9 @@ struct TransactionCallbackPayload {
  * write connections. The class will queue requests for connections and will
  * notify them they become available.
  *
- * Operations requesting locks here are synchronous and should be executed on a
- * single thread, however once a lock is active the connections can be used in a
- * thread pool for async statement executions.
+ * Operations requesting and releasing locks here are synchronous. They are
+ * guarded by a mutex and can be called from any thread. Once a lock is active
+ * the connections can be used in a thread pool for async statement executions.
  *
  * Synchronization, callback queueing and executions are managed by the
  * JavaScript portion of the library.
@@ -58,27 +145,61 @@ class ConnectionPool {
 private:
   int maxReads;
   std::string dbName;
+  std::string docPath;
+  // Slots of closed read connections are NULL. Only modified with the context
+  // mutex held, on the JS thread.
   ConnectionState **readConnections;
   ConnectionState writeConnection;
 
-  std::vector<ConnectionLockId> readQueue;
-  std::vector<ConnectionLockId> writeQueue;
+  // FIFO queues of lock contexts waiting for a connection
+  std::deque<LockRequest> readQueue;
+  std::deque<LockRequest> writeQueue;
+
+  // Read connections which are not locked to a context
+  std::vector<ConnectionState *> availableReadConnections;
+  // Connections of the currently active lock contexts
+  std::unordered_map<ConnectionLockId, ConnectionState *> activeContexts;
+  // Protects the queues, available connections and active contexts
+  std::mutex contextMutex;
+  // Used to generate context IDs for tasks which acquire their own lock
+  std::atomic<unsigned long> nextTaskContextId;
 
   // Cached constant payloads for c style commit/rollback callbacks
   const TransactionCallbackPayload commitPayload;
   const TransactionCallbackPayload rollbackPayload;
 
   void (*onContextCallback)(std::string, ConnectionLockId);
-  void (*onCommitCallback)(const TransactionCallbackPayload *);
+  TransactionFinalizerCallback onTransactionFinalizedCallback;
+  TransactionFinalizerCallback onTransactionCommittedCallback;
+
+  // Table changes of the current write transaction. These are collected on
+  // the write connection's thread and are reported in a single batch on
+  // commit.
+  std::vector<TableUpdates> pendingUpdates;
+  size_t lastUpdateIndex;
+  const ConnectionOptions options;
+  WalCheckpointScheduler checkpointScheduler;
+
+  // State which is applied to read connections opened after the pool
+  std::vector<std::pair<std::string, std::string>> attachStatements;
+  bool statsEnabled;
+  bool profileStatements;
 
   bool isConcurrencyEnabled;
 
 public:
   ConnectionPool(std::string dbName, std::string docPath,
-                 unsigned int numReadConnections);
+                 unsigned int numReadConnections,
+                 ConnectionOptions const &options = ConnectionOptions());
   ~ConnectionPool();
 
   friend int onCommitIntermediate(ConnectionPool *pool);
+  friend void onRollbackIntermediate(ConnectionPool *pool);
+  friend int onWalCommitIntermediate(ConnectionPool *pool, sqlite3 *db,
+                                     const char *dbName, int frames);
+  friend void onUpdateIntermediate(ConnectionPool *pool, int opType,
+                                   const char *dbName, const char *tableName,
+                                   sqlite3_int64 rowId);
 
   /**
    * Add a task to the read queue. If there are no available connections,
@@ -91,11 +212,26 @@ public:
    */
   void writeLock(ConnectionLockId contextId);
 
+  /**
+   * Runs a task once a read connection is available. The lock is released
+   * natively once the task completes, without a round trip to JS. `reject` is
+   * called if the task is dropped because the pool is closing.
+   */
+  void executeWithReadLock(ConnectionTask task, TaskRejection reject = nullptr);
+
+  /**
+   * Runs a task once the write connection is available. The lock is released
+   * natively once the task completes, without a round trip to JS. `reject` is
+   * called if the task is dropped because the pool is closing.
+   */
+  void executeWithWriteLock(ConnectionTask task,
+                            TaskRejection reject = nullptr);
+
   /**
    * Queue in context
    */
   SQLiteOPResult queueInContext(ConnectionLockId contextId,
-                                std::function<void(sqlite3 *)> task);
+                                ConnectionTask task);
 
   /**
    * Callback function when a new context is available for use
@@ -103,16 +239,18 @@ public:
   void setOnContextAvailable(void (*callback)(std::string, ConnectionLockId));
 
   /**
-   * Set a callback function for table updates
+   * Set a callback function for transaction commits/rollbacks.
+   * Table updates made during the transaction are provided on commit and are
+   * discarded on rollback.
    */
-  void setTableUpdateHandler(void (*callback)(void *, int, const char *,
-                                              const char *, sqlite3_int64));
+  void setTransactionFinalizerHandler(TransactionFinalizerCallback callback);
 
   /**
-   * Set a callback function for transaction commits/rollbacks
+   * Set a callback function for committed transactions which updated tables.
+   * Unlike the finalizer, it is called on the write connection's thread once
+   * the commit completed and the changes are visible to read connections.
    */
-  void setTransactionFinalizerHandler(
-      void (*callback)(const TransactionCallbackPayload *));
+  void setTransactionCommittedHandler(TransactionFinalizerCallback callback);
 
   /**
    * Close a context in order to progress queue
@@ -135,10 +273,95 @@ public:
 
   SQLiteOPResult detachDatabase(std::string const alias);
 
+  /**
+   * Enables or disables the instrumentation of all connections
+   */
+  void setStatsEnabled(bool enabled, bool profileStatements);
+
+  /**
+   * Returns the stats of all connections, the write connection is first.
+   * Stats are cleared after they are read if `reset` is true.
+   */
+  std::vector<ConnectionStatsSnapshot> getStats(bool reset);
+
+  /**
+   * Runs a background checkpoint once the write connection is idle. TRUNCATE
+   * checkpoints reset the WAL file, e.g. before the app is suspended.
+   * Only applies if background checkpoints are enabled.
+   */
+  void requestCheckpoint(bool truncate);
+
+  CheckpointStatsSnapshot getCheckpointStats();
+
+  /**
+   * Interrupts the statements running on the connection of the context. The
+   * interrupted statements fail, statements queued after them are not
+   * affected. Does nothing if the context was already released.
+   */
+  void interruptContext(ConnectionLockId contextId);
+  // Interrupts the statements running on all connections
+  void interruptAll();
+
+  /**
+   * Releases the page caches of all connections, e.g. on memory pressure.
+   * Idle read connections are closed if read connections are opened lazily.
+   */
+  void releaseMemory();
+
 private:
   std::vector<ConnectionState *> getAllConnections();
 
-  void activateContext(ConnectionState &state, ConnectionLockId contextId);
+  /**
+   * Opens a read connection and queues its setup. Attached databases and the
+   * stats settings match the other connections.
+   */
+  ConnectionState *openReadConnection();
+
+  /**
+   * Opens another read connection if none are available and the maximum has
+   * not been reached. Requires the context mutex to be held.
+   */
+  void ensureAvailableReadConnection();
+
+  /**
+   * Returns the connection locked to the context or NULL if the context is
+   * not active. Requires the context mutex to be held.
+   */
+  ConnectionState *findContext(const ConnectionLockId &contextId);
+
+  void requestReadLock(LockRequest request);
+  void requestWriteLock(LockRequest request);
+
+  ConnectionLockId generateTaskContextId();
+
+  /**
+   * Locks the connection to the context of the request. Returns false if the
+   * task of the request was dropped, the connection is not locked then.
+   */
+  bool activateContext(ConnectionState &state, LockRequest &request);
+
+  void closeCursors(ConnectionState &state);
+
+  /**
+   * Executes a statement on the worker threads of all connections and waits
+   * for it to complete. Results are in the order of the connections. The
+   * statements are queued with the context mutex held by `lock`, it is
+   * released while waiting.
+   */
+  std::vector<SequelLiteralUpdateResult>
+  executeOnConnections(std::string const &statement,
+                       std::unique_lock<std::mutex> &lock);
+
+  /**
+   * True if any context is active or waiting for a connection. Requires the
+   * context mutex.
+   */
+  bool isLocked();
+
+  /**
+   * Requires the context mutex.
+   */
+  void eraseAttachStatement(std::string const &alias);
 
   SQLiteOPResult genericSqliteOpenDb(string const dbName, string const docPath,
                                      sqlite3 **db, int sqlOpenFlags);
@@ -146,4 +369,12 @@ private:
 
 int onCommitIntermediate(ConnectionPool *pool);
 
+void onRollbackIntermediate(ConnectionPool *pool);
+
+void onUpdateIntermediate(ConnectionPool *pool, int opType, const char *dbName,
+                          const char *tableName, sqlite3_int64 rowId);
+
+int onWalCommitIntermediate(ConnectionPool *pool, sqlite3 *db,
+                            const char *dbName, int frames);
+
 #endif
\ No newline at end of file
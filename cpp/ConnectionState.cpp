@@ -1,5 +1,7 @@
 #include "ConnectionState.h"
+#include "SharedWorkerPool.h"
 #include "fileUtils.h"
+#include "logs.h"
 #include "sqlite3.h"
 
 const std::string EMPTY_LOCK_ID = "";
@@ -8,31 +10,44 @@ SQLiteOPResult genericSqliteOpenDb(string const dbName, string const docPath,
                                    sqlite3 **db, int sqlOpenFlags);
 
 ConnectionState::ConnectionState(const std::string dbName,
-                                 const std::string docPath, int SQLFlags) {
+                                 const std::string docPath, int SQLFlags,
+                                 bool useSharedWorkers)
+    : workQueue(WORK_QUEUE_INITIAL_CAPACITY),
+      useSharedWorkers(useSharedWorkers) {
   auto result = genericSqliteOpenDb(dbName, docPath, &connection, SQLFlags);
+  statementCache.attach(connection);
+  stats = std::make_shared<ConnectionStats>();
+  stats->attach(connection);
+  int64Results = false;
 
-  this->clearLock();
+  nextCursorId = 1;
+  openCursorCount = 0;
+#ifdef QUICK_SQLITE_HAS_SESSION
+  nextSessionId = 1;
+#endif
+  finishedWaiters = 0;
+  workerRunning = false;
+  workerWaiting = false;
+  taskRunning = false;
   threadDone = false;
-  thread = new std::thread(&ConnectionState::doWork, this);
-}
-
-ConnectionState::~ConnectionState() {
-  // So threads know it's time to shut down
-  threadDone = true;
+  idleTimeout = std::chrono::milliseconds(0);
+  this->clearLock();
 
-  // Wake up all the threads, so they can finish and be joined
-  workQueueConditionVariable.notify_all();
-  if (thread->joinable()) {
-    thread->join();
+  // Shared workers are only scheduled once tasks are queued
+  if (!useSharedWorkers) {
+    std::lock_guard<std::mutex> g(workQueueMutex);
+    startWorker();
   }
+}
 
-  delete thread;
+ConnectionState::~ConnectionState() {
+  // Only waits for the worker if the connection was not closed
+  stopWorker();
 }
 
 void ConnectionState::clearLock() {
-  if (!workQueue.empty()) {
-    waitFinished();
-  }
+  // Does not wait for queued tasks, the pool holds its context mutex while
+  // releasing a lock. Tasks of the next context are queued after them.
   _currentLockId = EMPTY_LOCK_ID;
 }
 
@@ -47,61 +62,274 @@ bool ConnectionState::matchesLock(const ConnectionLockId &lockId) {
 bool ConnectionState::isEmptyLock() { return _currentLockId == EMPTY_LOCK_ID; }
 
 void ConnectionState::close() {
-  if (!workQueue.empty()) {
-    waitFinished();
-  }
-  // So that the thread can stop (if not already)
-  threadDone = true;
+  // Queued tasks still run, the connection is closed once they completed
+  stopWorker();
+  // Statements need to be finalized for the connection to be released
+  closeAllCursors();
+#ifdef QUICK_SQLITE_HAS_SESSION
+  // Sessions have to be deleted before the connection is closed
+  closeAllSessions();
+#endif
+  statementCache.clear();
   sqlite3_close_v2(connection);
 }
 
-void ConnectionState::queueWork(std::function<void(sqlite3 *)> task) {
-  // Grab the mutex
+void ConnectionState::setIdleTimeout(std::chrono::milliseconds timeout) {
   std::lock_guard<std::mutex> g(workQueueMutex);
+  idleTimeout = timeout;
+  // The worker applies the timeout the next time it waits
+  if (workerWaiting) {
+    workAvailable.notify_one();
+  }
+}
+
+bool ConnectionState::isIdle() {
+  std::lock_guard<std::mutex> g(workQueueMutex);
+  return workQueue.empty() && !taskRunning;
+}
 
-  // Push the request to the queue
-  workQueue.push(task);
+bool ConnectionState::queueWork(ConnectionTask task, ConnectionTask then) {
+  auto queuedAt = stats->isEnabled() ? std::chrono::steady_clock::now()
+                                     : std::chrono::steady_clock::time_point();
 
-  // Notify one thread that there are requests to process
-  workQueueConditionVariable.notify_all();
+  std::lock_guard<std::mutex> g(workQueueMutex);
+  if (threadDone) {
+    // The connection is closing, the task could run after it was closed
+    LOGW("Dropped a task queued on a closed connection");
+    return false;
+  }
+
+  workQueue.push(QueuedTask{
+      .task = std::move(task),
+      .then = std::move(then),
+      .queuedAt = queuedAt,
+  });
+
+  if (!workerRunning) {
+    // The worker was parked while idle
+    startWorker();
+  } else if (workerWaiting) {
+    // Only the single worker can take the task, and it only needs to be woken
+    // if it is waiting
+    workAvailable.notify_one();
+  }
+  return true;
 }
 
+bool ConnectionState::isWorkerThread() {
+  return std::this_thread::get_id() == workerId.load();
+}
+
+unsigned int
+ConnectionState::openCursor(sqlite3_stmt *statement,
+                            std::shared_ptr<std::vector<QuickValue>> params) {
+  unsigned int cursorId = nextCursorId++;
+  cursors[cursorId] = Cursor{.statement = statement, .params = params};
+  openCursorCount = cursors.size();
+  return cursorId;
+}
+
+sqlite3_stmt *ConnectionState::getCursor(unsigned int cursorId) {
+  auto cursor = cursors.find(cursorId);
+  return cursor == cursors.end() ? nullptr : cursor->second.statement;
+}
+
+void ConnectionState::closeCursor(unsigned int cursorId) {
+  auto cursor = cursors.find(cursorId);
+  if (cursor == cursors.end()) {
+    return;
+  }
+  // Bindings are cleared before the values are released
+  statementCache.release(cursor->second.statement);
+  cursors.erase(cursor);
+  openCursorCount = cursors.size();
+}
+
+void ConnectionState::closeAllCursors() {
+  for (auto &cursor : cursors) {
+    statementCache.release(cursor.second.statement);
+  }
+  cursors.clear();
+  openCursorCount = 0;
+}
+
+bool ConnectionState::hasOpenCursors() { return openCursorCount > 0; }
+
+#ifdef QUICK_SQLITE_HAS_SESSION
+unsigned int ConnectionState::openSession(sqlite3_session *session) {
+  unsigned int sessionId = nextSessionId++;
+  sessions[sessionId] = session;
+  return sessionId;
+}
+
+sqlite3_session *ConnectionState::getSession(unsigned int sessionId) {
+  auto session = sessions.find(sessionId);
+  return session == sessions.end() ? nullptr : session->second;
+}
+
+void ConnectionState::closeSession(unsigned int sessionId) {
+  auto session = sessions.find(sessionId);
+  if (session == sessions.end()) {
+    return;
+  }
+
+  sqlite3session_delete(session->second);
+  sessions.erase(session);
+}
+
+void ConnectionState::closeAllSessions() {
+  for (auto &session : sessions) {
+    sqlite3session_delete(session.second);
+  }
+  sessions.clear();
+}
+#endif
+
 void ConnectionState::doWork() {
-  // Loop while the queue is not destructing
-  while (!threadDone) {
-    std::function<void(sqlite3 *)> task;
-
-    // Create a scope, so we don't lock the queue for longer than necessary
-    {
-      std::unique_lock<std::mutex> g(workQueueMutex);
-      workQueueConditionVariable.wait(g, [&] {
-        // Only wake up if there are elements in the queue or the program is
-        // shutting down
-        return !workQueue.empty() || threadDone;
-      });
-
-      // If we are shutting down exit without trying to process more work
-      if (threadDone) {
-        break;
+  workerId = std::this_thread::get_id();
+  std::unique_lock<std::mutex> g(workQueueMutex);
+
+  // Tasks queued before the connection started closing are still completed
+  while (!threadDone || !workQueue.empty()) {
+    if (workQueue.empty()) {
+      // Only wake up if there are elements in the queue or the connection is
+      // closing
+      auto isReady = [&] { return !workQueue.empty() || threadDone; };
+      bool isWoken = true;
+      workerWaiting = true;
+      if (idleTimeout.count() > 0) {
+        isWoken = workAvailable.wait_for(g, idleTimeout, isReady);
+      } else {
+        workAvailable.wait(g, isReady);
       }
+      workerWaiting = false;
 
-      task = workQueue.front();
-      workQueue.pop();
+      if (!isWoken) {
+        // Idle for the entire timeout. Release the page cache and exit until
+        // more work is queued.
+        taskRunning = true;
+        g.unlock();
+        sqlite3_db_release_memory(connection);
+        g.lock();
+        taskRunning = false;
+        if (workQueue.empty() && !threadDone) {
+          break;
+        }
+      }
+      continue;
     }
 
-    ++threadBusy;
-    task(connection);
-    --threadBusy;
-    // Need to notify in order for waitFinished to be updated when
-    // the queue is empty and not busy
-    workQueueConditionVariable.notify_all();
+    runNextTask(g);
+  }
+
+  workerRunning = false;
+  workerId = std::thread::id();
+  if (finishedWaiters > 0) {
+    workFinished.notify_all();
+  }
+}
+
+void ConnectionState::runNextTask(std::unique_lock<std::mutex> &g) {
+  QueuedTask queued = workQueue.pop();
+  taskRunning = true;
+  g.unlock();
+
+  if (stats->isEnabled() &&
+      queued.queuedAt != std::chrono::steady_clock::time_point()) {
+    std::chrono::duration<double, std::milli> wait =
+        std::chrono::steady_clock::now() - queued.queuedAt;
+    stats->recordQueueWait(wait.count());
+  }
+
+  queued.task(this);
+  if (queued.then) {
+    queued.then(this);
+  }
+  // Release captured values before waiters continue
+  queued = QueuedTask();
+
+  g.lock();
+  taskRunning = false;
+  // Need to notify in order for waitFinished to be updated when
+  // the queue is empty and not busy
+  if (finishedWaiters > 0 && workQueue.empty()) {
+    workFinished.notify_all();
+  }
+}
+
+void ConnectionState::runSharedWork() {
+  std::unique_lock<std::mutex> g(workQueueMutex);
+  workerId = std::this_thread::get_id();
+
+  for (int i = 0; i < SHARED_WORKER_BATCH_SIZE && !workQueue.empty(); i++) {
+    runNextTask(g);
+  }
+
+  // Cleared before another worker can take the connection
+  workerId = std::thread::id();
+  if (!workQueue.empty()) {
+    // Other connections run first, tasks queued later keep their order
+    SharedWorkerPool::getInstance().schedule(this);
+    return;
+  }
+
+  workerRunning = false;
+  // The connection can be deleted once the lock is released
+  if (finishedWaiters > 0) {
+    workFinished.notify_all();
+  }
+}
+
+void ConnectionState::startWorker() {
+  if (useSharedWorkers) {
+    workerRunning = true;
+    SharedWorkerPool::getInstance().schedule(this);
+    return;
+  }
+
+  // A parked worker has already exited, this does not block
+  if (thread.joinable()) {
+    thread.join();
+  }
+  workerRunning = true;
+  thread = std::thread(&ConnectionState::doWork, this);
+}
+
+void ConnectionState::stopWorker() {
+  {
+    std::lock_guard<std::mutex> g(workQueueMutex);
+    threadDone = true;
+    if (workerWaiting) {
+      workAvailable.notify_one();
+    }
+  }
+  if (useSharedWorkers) {
+    if (isWorkerThread()) {
+      return;
+    }
+    // The queued tasks still run on the shared workers
+    std::unique_lock<std::mutex> g(workQueueMutex);
+    finishedWaiters++;
+    workFinished.wait(g, [&] { return !workerRunning; });
+    finishedWaiters--;
+    return;
+  }
+  if (thread.joinable() && !isWorkerThread()) {
+    thread.join();
   }
 }
 
 void ConnectionState::waitFinished() {
+  // The worker can't wait for its own tasks
+  if (isWorkerThread()) {
+    return;
+  }
   std::unique_lock<std::mutex> g(workQueueMutex);
-  workQueueConditionVariable.wait(
-      g, [&] { return workQueue.empty() && (threadBusy == 0); });
+  finishedWaiters++;
+  workFinished.wait(g, [&] {
+    return (workQueue.empty() && !taskRunning) || !workerRunning;
+  });
+  finishedWaiters--;
 }
 
 SQLiteOPResult genericSqliteOpenDb(string const dbName, string const docPath,
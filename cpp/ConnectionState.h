@@ -1,10 +1,16 @@
+#include "ConnectionStats.h"
+#include "ConnectionTask.h"
 #include "JSIHelper.h"
+#include "PreparedStatementCache.h"
 #include "sqlite3.h"
+#include "sqliteSession.h"
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #ifndef ConnectionState_h
@@ -12,28 +18,73 @@
 
 typedef std::string ConnectionLockId;
 
+// Number of queued tasks before the work queue has to grow
+#define WORK_QUEUE_INITIAL_CAPACITY 16
+// Tasks run by a shared worker before other connections get their turn
+#define SHARED_WORKER_BATCH_SIZE 8
+
 class ConnectionState {
 public:
   // Only to be used by connection pool under some circumstances
   sqlite3 *connection;
+  // Prepared statements for this connection. Only to be used by tasks running
+  // on the worker thread.
+  PreparedStatementCache statementCache;
+  // Opt-in instrumentation. Shared so results can be recorded from the JS
+  // thread.
+  std::shared_ptr<ConnectionStats> stats;
+  // Read integer results as 64 bit values instead of doubles. Only changed
+  // before tasks are queued.
+  bool int64Results;
 
 private:
   ConnectionLockId _currentLockId;
   // Queue of requests waiting to be processed
-  std::queue<std::function<void(sqlite3 *)>> workQueue;
-  // Mutex to protect workQueue
+  ConnectionTaskQueue workQueue;
+  // Mutex to protect workQueue and the worker state below
   std::mutex workQueueMutex;
-  // Store thread in order to stop it gracefully
-  std::thread *thread;
-  // This condition variable is used for the threads to wait until there is work
-  // to do
-  std::condition_variable_any workQueueConditionVariable;
-  unsigned int threadBusy;
-  bool threadDone;
+  // Tasks run on the shared worker pool instead of an own thread
+  const bool useSharedWorkers;
+  // The worker is started with the connection and restarted on demand if it
+  // was parked. Unused with shared workers.
+  std::thread thread;
+  std::atomic<std::thread::id> workerId;
+  // The worker waits on this until there is work to do. It is only notified
+  // while the worker is waiting.
+  std::condition_variable workAvailable;
+  // Threads waiting for the queue to drain wait on this
+  std::condition_variable workFinished;
+  unsigned int finishedWaiters;
+  // False once the worker has exited, either parked or stopped. With shared
+  // workers, true while the connection is scheduled or running.
+  bool workerRunning;
+  bool workerWaiting;
+  bool taskRunning;
+  // Set once the connection is closing. The worker drains the queue and
+  // exits, no tasks are accepted after that.
+  std::atomic<bool> threadDone;
+  // Idle time after which the worker exits, zero keeps it running
+  std::chrono::milliseconds idleTimeout;
+  struct Cursor {
+    sqlite3_stmt *statement;
+    // Values bound to the statement
+    std::shared_ptr<std::vector<QuickValue>> params;
+  };
+  // Statements of open cursors. Only accessed from the worker thread.
+  std::unordered_map<unsigned int, Cursor> cursors;
+  unsigned int nextCursorId;
+  // Readable from any thread in order to clean up cursors on lock release
+  std::atomic<unsigned int> openCursorCount;
+#ifdef QUICK_SQLITE_HAS_SESSION
+  // Sessions recording changes on this connection. Only accessed from the
+  // worker thread.
+  std::unordered_map<unsigned int, sqlite3_session *> sessions;
+  unsigned int nextSessionId;
+#endif
 
 public:
   ConnectionState(const std::string dbName, const std::string docPath,
-                  int SQLFlags);
+                  int SQLFlags, bool useSharedWorkers = false);
   ~ConnectionState();
 
   void clearLock();
@@ -41,12 +92,67 @@ public:
   bool matchesLock(const ConnectionLockId &lockId);
   bool isEmptyLock();
 
+  /**
+   * Waits for all queued tasks to complete, stops the worker and closes the
+   * connection. Must not be called from the worker thread.
+   */
   void close();
-  void queueWork(std::function<void(sqlite3 *)> task);
+  /**
+   * Lets the worker thread exit after it has been idle for the timeout. The
+   * page cache is released before it exits, the worker is restarted once work
+   * is queued. Zero keeps the worker running. Ignored with shared workers.
+   */
+  void setIdleTimeout(std::chrono::milliseconds timeout);
+  // True if no tasks are queued or running
+  bool isIdle();
+  // Waits until no tasks are queued or running
+  void waitFinished();
+  /**
+   * Queues a task for the worker thread. `then` is executed right after the
+   * task, without queueing it separately.
+   * @returns false if the connection is closing, the task is dropped
+   */
+  bool queueWork(ConnectionTask task, ConnectionTask then = nullptr);
+  // True if called from a task running on this connection's worker thread
+  bool isWorkerThread();
+  /**
+   * Runs a batch of queued tasks on the calling shared worker thread and
+   * schedules the connection again if tasks remain
+   */
+  void runSharedWork();
+
+  /**
+   * Keeps a prepared statement alive between tasks so it can be stepped
+   * incrementally. The bound values are kept alive with the statement.
+   * Cursor methods must be called from the worker thread.
+   * @returns the ID of the cursor
+   */
+  unsigned int openCursor(sqlite3_stmt *statement,
+                          std::shared_ptr<std::vector<QuickValue>> params);
+  sqlite3_stmt *getCursor(unsigned int cursorId);
+  void closeCursor(unsigned int cursorId);
+  void closeAllCursors();
+  bool hasOpenCursors();
+
+#ifdef QUICK_SQLITE_HAS_SESSION
+  /**
+   * Keeps a session recording changes until it is closed. Session methods
+   * must be called from the worker thread.
+   * @returns the ID of the session
+   */
+  unsigned int openSession(sqlite3_session *session);
+  sqlite3_session *getSession(unsigned int sessionId);
+  void closeSession(unsigned int sessionId);
+  void closeAllSessions();
+#endif
 
 private:
   void doWork();
-  void waitFinished();
+  // Runs the next queued task, the lock is released while it runs
+  void runNextTask(std::unique_lock<std::mutex> &g);
+  // Requires the work queue mutex to be held
+  void startWorker();
+  void stopWorker();
 };
 
 #endif
@@ -0,0 +1,109 @@
+#include "ConnectionStats.h"
+
+/**
+ * Aggregates the execution time of statements with the same SQL
+ */
+int statementProfileCallback(unsigned int type, void *context, void *statement,
+                             void *duration) {
+  auto stats = (ConnectionStats *)context;
+  if (type != SQLITE_TRACE_PROFILE || !stats->isEnabled()) {
+    return 0;
+  }
+
+  const char *sql = sqlite3_sql((sqlite3_stmt *)statement);
+  if (sql == nullptr) {
+    return 0;
+  }
+  double ms = *(sqlite3_int64 *)duration / 1e6;
+
+  std::lock_guard<std::mutex> lock(stats->mutex);
+  auto profile = stats->statements.find(sql);
+  if (profile == stats->statements.end()) {
+    // Only a bounded number of statements are tracked
+    if (stats->statements.size() >= MAX_PROFILED_STATEMENTS) {
+      return 0;
+    }
+    profile = stats->statements.emplace(sql, StatementProfile{.sql = sql})
+                  .first;
+  }
+
+  profile->second.count++;
+  profile->second.totalMs += ms;
+  if (ms > profile->second.maxMs) {
+    profile->second.maxMs = ms;
+  }
+  return 0;
+}
+
+ConnectionStats::ConnectionStats()
+    : enabled(false), profileStatements(false), connection(nullptr),
+      isProfiling(false) {}
+
+void ConnectionStats::attach(sqlite3 *db) { connection = db; }
+
+void ConnectionStats::setEnabled(bool enabled, bool profileStatements) {
+  this->enabled = enabled;
+  this->profileStatements = enabled && profileStatements;
+}
+
+void ConnectionStats::applyProfiling() {
+  bool profile = profileStatements;
+  if (connection != nullptr && profile != isProfiling) {
+    sqlite3_trace_v2(connection, profile ? SQLITE_TRACE_PROFILE : 0,
+                     profile ? statementProfileCallback : nullptr,
+                     (void *)this);
+  }
+  isProfiling = profile;
+}
+
+bool ConnectionStats::isEnabled() const { return enabled; }
+
+void ConnectionStats::recordQueueWait(double ms) {
+  if (!enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  totals.tasks++;
+  totals.queueWaitMs += ms;
+  if (ms > totals.maxQueueWaitMs) {
+    totals.maxQueueWaitMs = ms;
+  }
+}
+
+void ConnectionStats::recordQuery(QueryStats const &query) {
+  if (!enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  totals.queries++;
+  totals.prepareMs += query.prepareMs;
+  totals.stepMs += query.stepMs;
+  totals.rows += query.rows;
+  totals.fullscanSteps += query.fullscanSteps;
+  totals.sorts += query.sorts;
+  totals.vmSteps += query.vmSteps;
+}
+
+void ConnectionStats::recordMarshalling(double ms) {
+  if (!enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  totals.marshallingMs += ms;
+}
+
+ConnectionStatsSnapshot ConnectionStats::snapshot() {
+  std::lock_guard<std::mutex> lock(mutex);
+  ConnectionStatsSnapshot result = totals;
+  result.statements.reserve(statements.size());
+  for (auto &statement : statements) {
+    result.statements.push_back(statement.second);
+  }
+  return result;
+}
+
+void ConnectionStats::reset() {
+  std::lock_guard<std::mutex> lock(mutex);
+  totals = ConnectionStatsSnapshot();
+  statements.clear();
+}
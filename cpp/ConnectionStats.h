@@ -0,0 +1,112 @@
+#include "sqlite3.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef ConnectionStats_h
+#define ConnectionStats_h
+
+// Upper bound of distinct SQL statements which are profiled per connection
+#define MAX_PROFILED_STATEMENTS 100
+
+/**
+ * Measurements of a single statement execution
+ */
+struct QueryStats {
+  double prepareMs = 0;
+  double stepMs = 0;
+  unsigned long rows = 0;
+  // Counters from sqlite3_stmt_status
+  unsigned long fullscanSteps = 0;
+  unsigned long sorts = 0;
+  unsigned long vmSteps = 0;
+};
+
+/**
+ * Aggregated execution times of a single SQL statement, reported by
+ * sqlite3_trace_v2 profile events
+ */
+struct StatementProfile {
+  std::string sql;
+  unsigned long count = 0;
+  double totalMs = 0;
+  double maxMs = 0;
+};
+
+/**
+ * Aggregated measurements of a connection
+ */
+struct ConnectionStatsSnapshot {
+  unsigned long tasks = 0;
+  double queueWaitMs = 0;
+  double maxQueueWaitMs = 0;
+
+  unsigned long queries = 0;
+  double prepareMs = 0;
+  double stepMs = 0;
+  double marshallingMs = 0;
+  unsigned long rows = 0;
+  unsigned long fullscanSteps = 0;
+  unsigned long sorts = 0;
+  unsigned long vmSteps = 0;
+
+  // Filled in from the prepared statement cache of the connection
+  unsigned long statementCacheHits = 0;
+  unsigned long statementCacheMisses = 0;
+
+  std::vector<StatementProfile> statements;
+};
+
+/**
+ * Opt-in instrumentation of a single connection.
+ *
+ * Measurements are recorded from the worker thread of the connection and from
+ * the JS thread (result marshalling). They are aggregated in memory and can be
+ * read from any thread. Nothing is recorded while the stats are disabled.
+ */
+class ConnectionStats {
+private:
+  std::atomic<bool> enabled;
+  std::atomic<bool> profileStatements;
+  sqlite3 *connection;
+  // Only accessed from the worker thread
+  bool isProfiling;
+
+  std::mutex mutex;
+  ConnectionStatsSnapshot totals;
+  std::unordered_map<std::string, StatementProfile> statements;
+
+public:
+  ConnectionStats();
+
+  friend int statementProfileCallback(unsigned int type, void *context,
+                                      void *statement, void *duration);
+
+  /**
+   * Binds the stats to a connection, required for statement profiling
+   */
+  void attach(sqlite3 *db);
+
+  /**
+   * Enables or disables recording. Statement profiling takes effect once
+   * `applyProfiling` was called.
+   */
+  void setEnabled(bool enabled, bool profileStatements);
+  /**
+   * Registers or removes the sqlite3_trace_v2 callback for statement
+   * profiling. Must be called from the worker thread.
+   */
+  void applyProfiling();
+  bool isEnabled() const;
+
+  void recordQueueWait(double ms);
+  void recordQuery(QueryStats const &query);
+  void recordMarshalling(double ms);
+
+  ConnectionStatsSnapshot snapshot();
+  void reset();
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef ConnectionTask_h
+#define ConnectionTask_h
+
+// Callables up to this size are stored inside the task without allocating.
+// This fits the statement execution tasks created by the bindings.
+#define CONNECTION_TASK_INLINE_SIZE 128
+
+class ConnectionState;
+
+/**
+ * Move-only work executed on the worker thread of a connection.
+ *
+ * Unlike std::function, which only stores very small callables inline, lambdas
+ * capturing a query, its parameters and the promise callbacks are stored in
+ * the task itself. Larger callables are allocated on the heap.
+ */
+class ConnectionTask {
+private:
+  struct Operations {
+    void (*invoke)(void *storage, ConnectionState *state);
+    // Move constructs the callable into `to` and destroys the one in `from`
+    void (*relocate)(void *from, void *to);
+    void (*destroy)(void *storage);
+  };
+
+  template <typename F> struct InlineOperations {
+    static void invoke(void *storage, ConnectionState *state) {
+      (*static_cast<F *>(storage))(state);
+    }
+    static void relocate(void *from, void *to) {
+      new (to) F(std::move(*static_cast<F *>(from)));
+      static_cast<F *>(from)->~F();
+    }
+    static void destroy(void *storage) { static_cast<F *>(storage)->~F(); }
+    static constexpr Operations operations = {invoke, relocate, destroy};
+  };
+
+  template <typename F> struct HeapOperations {
+    static void invoke(void *storage, ConnectionState *state) {
+      (**static_cast<F **>(storage))(state);
+    }
+    static void relocate(void *from, void *to) {
+      *static_cast<F **>(to) = *static_cast<F **>(from);
+    }
+    static void destroy(void *storage) { delete *static_cast<F **>(storage); }
+    static constexpr Operations operations = {invoke, relocate, destroy};
+  };
+
+  template <typename F>
+  static constexpr bool fitsInline =
+      sizeof(F) <= CONNECTION_TASK_INLINE_SIZE &&
+      alignof(F) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible<F>::value;
+
+  alignas(std::max_align_t) unsigned char storage[CONNECTION_TASK_INLINE_SIZE];
+  const Operations *operations;
+
+  void reset() {
+    if (operations != nullptr) {
+      operations->destroy(storage);
+      operations = nullptr;
+    }
+  }
+
+public:
+  ConnectionTask() noexcept : operations(nullptr) {}
+  ConnectionTask(std::nullptr_t) noexcept : operations(nullptr) {}
+
+  template <typename F,
+            typename = std::enable_if_t<
+                !std::is_same<std::decay_t<F>, ConnectionTask>::value &&
+                std::is_invocable<std::decay_t<F> &, ConnectionState *>::value>>
+  ConnectionTask(F &&callable) {
+    typedef std::decay_t<F> Callable;
+    if constexpr (fitsInline<Callable>) {
+      new (storage) Callable(std::forward<F>(callable));
+      operations = &InlineOperations<Callable>::operations;
+    } else {
+      *reinterpret_cast<Callable **>(storage) =
+          new Callable(std::forward<F>(callable));
+      operations = &HeapOperations<Callable>::operations;
+    }
+  }
+
+  ConnectionTask(ConnectionTask &&other) noexcept
+      : operations(other.operations) {
+    if (operations != nullptr) {
+      operations->relocate(other.storage, storage);
+      other.operations = nullptr;
+    }
+  }
+
+  ConnectionTask &operator=(ConnectionTask &&other) noexcept {
+    if (this != &other) {
+      reset();
+      operations = other.operations;
+      if (operations != nullptr) {
+        operations->relocate(other.storage, storage);
+        other.operations = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  ConnectionTask(ConnectionTask const &) = delete;
+  ConnectionTask &operator=(ConnectionTask const &) = delete;
+
+  ~ConnectionTask() { reset(); }
+
+  void operator()(ConnectionState *state) {
+    operations->invoke(storage, state);
+  }
+
+  explicit operator bool() const noexcept { return operations != nullptr; }
+};
+
+/**
+ * A task waiting in the work queue of a connection
+ */
+struct QueuedTask {
+  ConnectionTask task;
+  // Runs after the task, e.g. to release the lock the task executed with
+  ConnectionTask then;
+  std::chrono::steady_clock::time_point queuedAt;
+};
+
+/**
+ * FIFO ring buffer of queued tasks. Slots are reused, the buffer only
+ * allocates when it grows. Not thread safe.
+ */
+class ConnectionTaskQueue {
+private:
+  std::vector<QueuedTask> slots;
+  size_t head;
+  size_t count;
+
+public:
+  ConnectionTaskQueue(size_t capacity) : slots(capacity), head(0), count(0) {}
+
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+
+  void push(QueuedTask &&task) {
+    if (count == slots.size()) {
+      // Grow while keeping the order of the queued tasks
+      std::vector<QueuedTask> grown(slots.size() * 2);
+      for (size_t i = 0; i < count; i++) {
+        grown[i] = std::move(slots[(head + i) % slots.size()]);
+      }
+      slots = std::move(grown);
+      head = 0;
+    }
+    slots[(head + count) % slots.size()] = std::move(task);
+    count++;
+  }
+
+  QueuedTask pop() {
+    QueuedTask task = std::move(slots[head]);
+    head = (head + 1) % slots.size();
+    count--;
+    return task;
+  }
+};
+
+#endif
@@ -20,50 +20,56 @@ QuickValue createBooleanQuickValue(bool value)
 {
   return QuickValue{
     .dataType = BOOLEAN,
-    .booleanValue = int(value)};
+    .storage = int(value)};
 }
 
-QuickValue createTextQuickValue(string value)
+QuickValue createTextQuickValue(string &&value)
 {
   return QuickValue{
     .dataType = TEXT,
-    .textValue = value};
+    .storage = std::move(value)};
+}
+
+QuickValue createTextQuickValue(const char *value, size_t length)
+{
+  return QuickValue{
+    .dataType = TEXT,
+    .storage = string(value, length)};
 }
 
 QuickValue createIntegerQuickValue(int value)
 {
   return QuickValue{
     .dataType = INTEGER,
-    .doubleOrIntValue = static_cast<double>(value)};
+    .storage = static_cast<double>(value)};
 }
 
 QuickValue createIntegerQuickValue(double value)
 {
   return QuickValue{
     .dataType = INTEGER,
-    .doubleOrIntValue = value};
+    .storage = value};
 }
 
 QuickValue createInt64QuickValue(long long value)
 {
   return QuickValue{
     .dataType = INT64,
-    .int64Value = value};
+    .storage = value};
 }
 
 QuickValue createDoubleQuickValue(double value)
 {
   return QuickValue{
     .dataType = DOUBLE,
-    .doubleOrIntValue = value};
+    .storage = value};
 }
 
-QuickValue createArrayBufferQuickValue(uint8_t *arrayBufferValue, size_t arrayBufferSize)
+QuickValue createArrayBufferQuickValue(const uint8_t *arrayBufferValue, size_t arrayBufferSize)
 {
   return QuickValue{
     .dataType = ARRAY_BUFFER,
-    .arrayBufferValue = shared_ptr<uint8_t>{arrayBufferValue},
-    .arrayBufferSize = arrayBufferSize};
+    .storage = make_shared<QuickArrayBuffer>(arrayBufferValue, arrayBufferSize)};
 }
 
 void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &params, vector<QuickValue> *target)
@@ -74,8 +80,10 @@ void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &params,
   }
 
   jsi::Array values = params.asObject(rt).asArray(rt);
+  size_t length = values.length(rt);
+  target->reserve(target->size() + length);
 
-  for (int ii = 0; ii < values.length(rt); ii++)
+  for (int ii = 0; ii < length; ii++)
   {
 
     jsi::Value value = values.getValueAtIndex(rt, ii);
@@ -91,7 +99,7 @@ void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &params,
     {
       double doubleVal = value.asNumber();
       int intVal = (int)doubleVal;
-      long long longVal = (long)doubleVal;
+      long long longVal = (long long)doubleVal;
       if (intVal == doubleVal)
       {
         target->push_back(createIntegerQuickValue(intVal));
@@ -105,10 +113,14 @@ void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &params,
         target->push_back(createDoubleQuickValue(doubleVal));
       }
     }
+    else if (value.isBigInt())
+    {
+      // Throws if the value doesn't fit into 64 bits
+      target->push_back(createInt64QuickValue(value.getBigInt(rt).asInt64(rt)));
+    }
     else if (value.isString())
     {
-      string strVal = value.asString(rt).utf8(rt);
-      target->push_back(createTextQuickValue(strVal));
+      target->push_back(createTextQuickValue(value.asString(rt).utf8(rt)));
     }
     else if (value.isObject())
     {
@@ -126,65 +138,186 @@ void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &params,
   }
 }
 
-jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, vector<map<string, QuickValue>> *results, vector<QuickColumnMetadata> *metadata)
+QuickQueryOptions jsiQueryOptions(jsi::Runtime &rt, jsi::Value const &options)
 {
-  if(status.type == SQLiteError) {
-    throw std::invalid_argument(status.errorMessage);
+  QuickQueryOptions result;
+  if (options.isNull() || options.isUndefined())
+  {
+    return result;
   }
 
-  jsi::Object res = jsi::Object(rt);
-
-  res.setProperty(rt, "rowsAffected", jsi::Value(status.rowsAffected));
-  if (status.rowsAffected > 0 && status.insertId != 0)
+  auto optionsObject = options.asObject(rt);
+  auto compact = optionsObject.getProperty(rt, "compact");
+  if (compact.isBool() && compact.getBool())
   {
-    res.setProperty(rt, "insertId", jsi::Value(status.insertId));
+    result.resultFormat = RESULT_COMPACT;
   }
 
-  // Converting row results into objects
-  size_t rowCount = results->size();
-  jsi::Object rows = jsi::Object(rt);
-  if (rowCount > 0)
+  auto typedColumns = optionsObject.getProperty(rt, "typedColumns");
+  if (typedColumns.isObject())
   {
-    auto array = jsi::Array(rt, rowCount);
-    for (int i = 0; i < rowCount; i++)
+    auto columnsObject = typedColumns.asObject(rt);
+    auto names = columnsObject.getPropertyNames(rt);
+    size_t length = names.size(rt);
+    for (size_t i = 0; i < length; i++)
     {
-      jsi::Object rowObject = jsi::Object(rt);
-      auto row = results->at(i);
-      for (auto const &entry : row)
+      auto name = names.getValueAtIndex(rt, i).asString(rt);
+      auto type = columnsObject.getProperty(rt, name).asString(rt).utf8(rt);
+      if (type == "float64")
       {
-        std::string columnName = entry.first;
-        QuickValue value = entry.second;
-        if (value.dataType == TEXT)
-        {
-          // using value.textValue (std::string) directly allows jsi::String to use length property of std::string (allowing strings with NULLs in them like SQLite does)
-          rowObject.setProperty(rt, columnName.c_str(), jsi::String::createFromUtf8(rt, value.textValue));
-        }
-        else if (value.dataType == INTEGER)
-        {
-          rowObject.setProperty(rt, columnName.c_str(), jsi::Value(value.doubleOrIntValue));
-        }
-        else if (value.dataType == DOUBLE)
-        {
-          rowObject.setProperty(rt, columnName.c_str(), jsi::Value(value.doubleOrIntValue));
-        }
-        else if (value.dataType == ARRAY_BUFFER)
-        {
-          jsi::Function array_buffer_ctor = rt.global().getPropertyAsFunction(rt, "ArrayBuffer");
-          jsi::Object o = array_buffer_ctor.callAsConstructor(rt, (int)value.arrayBufferSize).getObject(rt);
-          jsi::ArrayBuffer buf = o.getArrayBuffer(rt);
-          // It's a shame we have to copy here: see https://github.com/facebook/hermes/pull/419 and https://github.com/facebook/hermes/issues/564.
-          memcpy(buf.data(rt), value.arrayBufferValue.get(), value.arrayBufferSize);
-          rowObject.setProperty(rt, columnName.c_str(), o);
-        }
-        else
-        {
-          rowObject.setProperty(rt, columnName.c_str(), jsi::Value(nullptr));
-        }
+        result.typedColumns.push_back(make_pair(name.utf8(rt), TYPED_FLOAT64));
+      }
+      else if (type == "int32")
+      {
+        result.typedColumns.push_back(make_pair(name.utf8(rt), TYPED_INT32));
+      }
+      else
+      {
+        throw jsi::JSError(rt, "[react-native-quick-sqlite] Unsupported typed column type: " + type);
       }
-      array.setValueAtIndex(rt, i, move(rowObject));
     }
-    rows.setProperty(rt, "_array", move(array));
-    res.setProperty(rt, "rows", move(rows));
+    result.resultFormat = RESULT_TYPED_COLUMNS;
+  }
+
+  auto maxRows = optionsObject.getProperty(rt, "maxRows");
+  if (maxRows.isNumber() && maxRows.asNumber() > 0)
+  {
+    result.limits.maxRows = (size_t)maxRows.asNumber();
+  }
+  auto maxBytes = optionsObject.getProperty(rt, "maxBytes");
+  if (maxBytes.isNumber() && maxBytes.asNumber() > 0)
+  {
+    result.limits.maxBytes = (size_t)maxBytes.asNumber();
+  }
+
+  auto lazyRows = optionsObject.getProperty(rt, "lazyRows");
+  if (lazyRows.isBool() && lazyRows.getBool())
+  {
+    result.resultFormat = RESULT_LAZY_ROWS;
+  }
+
+  return result;
+}
+
+/**
+ * State shared while converting the values of a single result set
+ */
+struct QuickValueConverter
+{
+  // Cleared once the runtime has rejected an externally backed ArrayBuffer
+  bool useMutableBuffers = true;
+  // Only looked up when needed, and only once per result set
+  unique_ptr<jsi::Function> arrayBufferConstructor;
+  // Cleared once the runtime has failed to create a BigInt
+  bool useBigInts = true;
+};
+
+// Integers in this range are exactly representable as JS numbers
+#define MAX_SAFE_INTEGER 9007199254740991LL
+
+/**
+ * Creates a number for integers which fit into a double without losing
+ * precision and a BigInt for all other integers. Runtimes without BigInt
+ * support get the decimal string instead.
+ */
+static jsi::Value createJSIInteger(jsi::Runtime &rt, QuickValueConverter &converter, long long value)
+{
+  if (value >= -MAX_SAFE_INTEGER && value <= MAX_SAFE_INTEGER)
+  {
+    return jsi::Value((double)value);
+  }
+
+  if (converter.useBigInts)
+  {
+    try
+    {
+      return jsi::BigInt::fromInt64(rt, value);
+    }
+    catch (std::exception &)
+    {
+      converter.useBigInts = false;
+    }
+  }
+  return jsi::String::createFromAscii(rt, to_string(value));
+}
+
+static jsi::Value createJSIArrayBuffer(jsi::Runtime &rt, QuickValueConverter &converter, shared_ptr<QuickArrayBuffer> const &buffer)
+{
+  if (converter.useMutableBuffers)
+  {
+    try
+    {
+      // The ArrayBuffer keeps the native buffer alive, no copy is required
+      return jsi::ArrayBuffer(rt, buffer);
+    }
+    catch (std::exception &)
+    {
+      // Some runtimes (e.g. older JSC versions) can't create ArrayBuffers from native memory
+      converter.useMutableBuffers = false;
+    }
+  }
+
+  if (converter.arrayBufferConstructor == nullptr)
+  {
+    converter.arrayBufferConstructor = make_unique<jsi::Function>(rt.global().getPropertyAsFunction(rt, "ArrayBuffer"));
+  }
+  jsi::Object o = converter.arrayBufferConstructor->callAsConstructor(rt, (int)buffer->size()).getObject(rt);
+  jsi::ArrayBuffer buf = o.getArrayBuffer(rt);
+  memcpy(buf.data(rt), buffer->data(), buffer->size());
+  return o;
+}
+
+jsi::Value createJSIArrayBuffer(jsi::Runtime &rt, shared_ptr<QuickArrayBuffer> const &buffer)
+{
+  QuickValueConverter converter;
+  return createJSIArrayBuffer(rt, converter, buffer);
+}
+
+/**
+ * Converts a single result value to its JSI representation
+ */
+static jsi::Value quickValueToJSIValue(jsi::Runtime &rt, QuickValueConverter &converter, QuickValue const &value)
+{
+  if (value.dataType == TEXT)
+  {
+    // using value.textValue (std::string) directly allows jsi::String to use length property of std::string (allowing strings with NULLs in them like SQLite does)
+    return jsi::String::createFromUtf8(rt, value.textValue());
+  }
+  else if (value.dataType == INTEGER)
+  {
+    return jsi::Value(value.doubleOrIntValue());
+  }
+  else if (value.dataType == DOUBLE)
+  {
+    return jsi::Value(value.doubleOrIntValue());
+  }
+  else if (value.dataType == INT64)
+  {
+    return createJSIInteger(rt, converter, value.int64Value());
+  }
+  else if (value.dataType == ARRAY_BUFFER)
+  {
+    return createJSIArrayBuffer(rt, converter, value.arrayBufferValue());
+  }
+
+  return jsi::Value(nullptr);
+}
+
+/**
+ * Creates the result object with the properties shared by all result formats
+ */
+static jsi::Object createResultObject(jsi::Runtime &rt, SQLiteOPResult const &status, vector<QuickColumnMetadata> *metadata)
+{
+  if(status.type == SQLiteError) {
+    throw std::invalid_argument(status.errorMessage);
+  }
+
+  jsi::Object res = jsi::Object(rt);
+
+  res.setProperty(rt, "rowsAffected", jsi::Value(status.rowsAffected));
+  if (status.rowsAffected > 0 && status.insertId != 0)
+  {
+    res.setProperty(rt, "insertId", jsi::Value(status.insertId));
   }
 
   if(metadata != NULL)
@@ -192,7 +325,7 @@ jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult sta
     size_t column_count = metadata->size();
     auto column_array = jsi::Array(rt, column_count);
     for (int i = 0; i < column_count; i++) {
-      auto column = metadata->at(i);
+      auto &column = metadata->at(i);
       jsi::Object column_object = jsi::Object(rt);
       column_object.setProperty(rt, "columnName", jsi::String::createFromUtf8(rt, column.colunmName.c_str()));
       column_object.setProperty(rt, "columnDeclaredType", jsi::String::createFromUtf8(rt, column.columnDeclaredType.c_str()));
@@ -201,7 +334,170 @@ jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult sta
     }
     res.setProperty(rt, "metadata", move(column_array));
   }
-  rows.setProperty(rt, "length", jsi::Value((int)rowCount));
 
+  return res;
+}
+
+/**
+ * Property names of the columns, created once and shared by all the row objects
+ */
+static vector<jsi::PropNameID> createColumnPropNames(jsi::Runtime &rt, QuickQueryResult const *results)
+{
+  vector<jsi::PropNameID> columnNames;
+  columnNames.reserve(results->columnNames.size());
+  for (auto const &columnName : results->columnNames)
+  {
+    columnNames.push_back(jsi::PropNameID::forUtf8(rt, columnName));
+  }
+  return columnNames;
+}
+
+static jsi::Object createRowObject(jsi::Runtime &rt, QuickValueConverter &converter, QuickQueryResult const *results, vector<jsi::PropNameID> const &columnNames, size_t row)
+{
+  jsi::Object rowObject = jsi::Object(rt);
+  size_t columnCount = columnNames.size();
+  size_t offset = row * columnCount;
+  for (int c = 0; c < columnCount; c++)
+  {
+    rowObject.setProperty(rt, columnNames[c], quickValueToJSIValue(rt, converter, results->values[offset + c]));
+  }
+  return rowObject;
+}
+
+static jsi::Array createRowsArray(jsi::Runtime &rt, QuickQueryResult const *results)
+{
+  auto columnNames = createColumnPropNames(rt, results);
+  QuickValueConverter converter;
+  auto array = jsi::Array(rt, results->rowCount);
+  for (int i = 0; i < results->rowCount; i++)
+  {
+    array.setValueAtIndex(rt, i, createRowObject(rt, converter, results, columnNames, i));
+  }
+  return array;
+}
+
+jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, QuickQueryResult *results, vector<QuickColumnMetadata> *metadata)
+{
+  jsi::Object res = createResultObject(rt, status, metadata);
+
+  // Converting row results into objects
+  size_t rowCount = results->rowCount;
+  jsi::Object rows = jsi::Object(rt);
+  if (rowCount > 0)
+  {
+    rows.setProperty(rt, "_array", createRowsArray(rt, results));
+    rows.setProperty(rt, "length", jsi::Value((int)rowCount));
+    res.setProperty(rt, "rows", move(rows));
+  }
+
+  return move(res);
+}
+
+jsi::Value createCompactQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, QuickQueryResult *results, vector<QuickColumnMetadata> *metadata)
+{
+  jsi::Object res = createResultObject(rt, status, metadata);
+
+  size_t columnCount = results->columnNames.size();
+  auto columns = jsi::Array(rt, columnCount);
+  for (int c = 0; c < columnCount; c++)
+  {
+    columns.setValueAtIndex(rt, c, jsi::String::createFromUtf8(rt, results->columnNames[c]));
+  }
+
+  QuickValueConverter converter;
+  size_t valueCount = results->values.size();
+  auto values = jsi::Array(rt, valueCount);
+  for (int i = 0; i < valueCount; i++)
+  {
+    values.setValueAtIndex(rt, i, quickValueToJSIValue(rt, converter, results->values[i]));
+  }
+
+  res.setProperty(rt, "columns", move(columns));
+  res.setProperty(rt, "values", move(values));
+  res.setProperty(rt, "length", jsi::Value((int)results->rowCount));
+
+  return move(res);
+}
+
+jsi::Value createTypedColumnsQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, QuickQueryResult *results, vector<QuickColumnMetadata> *metadata)
+{
+  jsi::Object res = createResultObject(rt, status, metadata);
+
+  QuickValueConverter converter;
+  auto float64ArrayConstructor = rt.global().getPropertyAsFunction(rt, "Float64Array");
+  auto int32ArrayConstructor = rt.global().getPropertyAsFunction(rt, "Int32Array");
+  auto uint8ArrayConstructor = rt.global().getPropertyAsFunction(rt, "Uint8Array");
+
+  jsi::Object columns = jsi::Object(rt);
+  for (auto &column : results->typedColumns)
+  {
+    // The typed arrays are views on the buffers filled by the worker thread
+    auto values = createJSIArrayBuffer(rt, converter, make_shared<QuickArrayBuffer>(move(column.values)));
+    auto nulls = createJSIArrayBuffer(rt, converter, make_shared<QuickArrayBuffer>(move(column.nulls)));
+    auto &constructor = column.type == TYPED_INT32 ? int32ArrayConstructor : float64ArrayConstructor;
+
+    jsi::Object typedColumn = jsi::Object(rt);
+    typedColumn.setProperty(rt, "values", constructor.callAsConstructor(rt, move(values)));
+    typedColumn.setProperty(rt, "nulls", uint8ArrayConstructor.callAsConstructor(rt, move(nulls)));
+    columns.setProperty(rt, column.name.c_str(), move(typedColumn));
+  }
+
+  res.setProperty(rt, "columns", move(columns));
+  res.setProperty(rt, "length", jsi::Value((int)results->rowCount));
+
+  return move(res);
+}
+
+QuickRowsHostObject::QuickRowsHostObject(shared_ptr<QuickQueryResult> results) : results(results) {}
+
+jsi::Value QuickRowsHostObject::get(jsi::Runtime &rt, const jsi::PropNameID &name)
+{
+  auto property = name.utf8(rt);
+  if (property == "length")
+  {
+    return jsi::Value((int)results->rowCount);
+  }
+  else if (property == "item")
+  {
+    // The function keeps the results alive, not the host object
+    auto results = this->results;
+    return jsi::Function::createFromHostFunction(rt, name, 1, [results](jsi::Runtime &rt, const jsi::Value &thisValue, const jsi::Value *args, size_t count) -> jsi::Value
+    {
+      if (count < 1 || !args[0].isNumber())
+      {
+        return jsi::Value::undefined();
+      }
+      double index = args[0].asNumber();
+      if (index < 0 || index >= results->rowCount || index != (size_t)index)
+      {
+        return jsi::Value::undefined();
+      }
+      QuickValueConverter converter;
+      return createRowObject(rt, converter, results.get(), createColumnPropNames(rt, results.get()), (size_t)index);
+    });
+  }
+  else if (property == "_array")
+  {
+    return createRowsArray(rt, results.get());
+  }
+  return jsi::Value::undefined();
+}
+
+vector<jsi::PropNameID> QuickRowsHostObject::getPropertyNames(jsi::Runtime &rt)
+{
+  vector<jsi::PropNameID> names;
+  names.push_back(jsi::PropNameID::forAscii(rt, "length"));
+  names.push_back(jsi::PropNameID::forAscii(rt, "item"));
+  names.push_back(jsi::PropNameID::forAscii(rt, "_array"));
+  return names;
+}
+
+jsi::Value createLazyRowsQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, shared_ptr<QuickQueryResult> results, vector<QuickColumnMetadata> *metadata)
+{
+  jsi::Object res = createResultObject(rt, status, metadata);
+  if (results->rowCount > 0)
+  {
+    res.setProperty(rt, "rows", jsi::Object::createFromHostObject(rt, make_shared<QuickRowsHostObject>(results)));
+  }
   return move(res);
 }
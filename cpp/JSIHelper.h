@@ -13,6 +13,7 @@
 #include <jsi/jsi.h>
 #include <vector>
 #include <map>
+#include <variant>
 
 using namespace std;
 using namespace facebook;
@@ -32,17 +33,38 @@ enum QuickDataType
 };
 
 /**
- * Wrapper struct to allocate dynamic JSI values to static C++ primitives
+ * Natively owned bytes of a blob value. The buffer can be handed to JSI as the
+ * backing store of an ArrayBuffer without copying it.
+ */
+class QuickArrayBuffer : public jsi::MutableBuffer
+{
+public:
+  QuickArrayBuffer(const uint8_t *data, size_t size) : storage(data, data + size) {}
+  QuickArrayBuffer(vector<uint8_t> &&storage) : storage(move(storage)) {}
+
+  size_t size() const override { return storage.size(); }
+  uint8_t *data() override { return storage.data(); }
+
+private:
+  vector<uint8_t> storage;
+};
+
+/**
+ * Wrapper struct to allocate dynamic JSI values to static C++ primitives.
+ * Only the member for the data type is stored: an int for BOOLEAN, a double
+ * for INTEGER and DOUBLE, a long long for INT64, a string for TEXT and a
+ * buffer for ARRAY_BUFFER. Values should be moved rather than copied.
  */
 struct QuickValue
 {
   QuickDataType dataType;
-  int booleanValue;
-  double doubleOrIntValue;
-  long long int64Value;
-  string textValue;
-  shared_ptr<uint8_t> arrayBufferValue;
-  size_t arrayBufferSize;
+  variant<monostate, int, double, long long, string, shared_ptr<QuickArrayBuffer>> storage;
+
+  int booleanValue() const { return get<int>(storage); }
+  double doubleOrIntValue() const { return get<double>(storage); }
+  long long int64Value() const { return get<long long>(storage); }
+  string const &textValue() const { return get<string>(storage); }
+  shared_ptr<QuickArrayBuffer> const &arrayBufferValue() const { return get<shared_ptr<QuickArrayBuffer>>(storage); }
 };
 
 /**
@@ -54,6 +76,81 @@ struct QuickColumnValue
   string columnName;
 };
 
+/**
+ * Element type of a column which is returned as a typed array
+ */
+enum QuickTypedColumnType
+{
+  TYPED_FLOAT64,
+  TYPED_INT32,
+};
+
+/**
+ * A single column read into the raw bytes of a typed array. Bit `r % 8` of
+ * byte `r / 8` in `nulls` is set if the value in row `r` is NULL, the value
+ * itself is then 0.
+ */
+struct QuickTypedColumn
+{
+  string name;
+  QuickTypedColumnType type;
+  int columnIndex = -1;
+  vector<uint8_t> values;
+  vector<uint8_t> nulls;
+};
+
+/**
+ * Result set of a query. Column names are stored once, values are stored
+ * row-major: the value of column `c` in row `r` is at `r * columnCount + c`.
+ * If typed columns are requested, only those columns are read and `values`
+ * stays empty.
+ */
+struct QuickQueryResult
+{
+  vector<string> columnNames;
+  vector<QuickValue> values;
+  vector<QuickTypedColumn> typedColumns;
+  size_t rowCount = 0;
+  // Integers are stored as INT64 values instead of doubles
+  bool int64Values = false;
+};
+
+/**
+ * Shape of the query results returned to JavaScript
+ */
+enum QuickResultFormat
+{
+  // `rows._array` with an object per row
+  RESULT_ROWS,
+  // Column names and a flat row-major array of values
+  RESULT_COMPACT,
+  // Selected numeric columns as typed arrays
+  RESULT_TYPED_COLUMNS,
+  // `rows` host object which converts rows when they are read
+  RESULT_LAZY_ROWS,
+};
+
+/**
+ * Bounds of a result set, a query fails once one of them is exceeded. Zero is unlimited.
+ */
+struct QueryLimits
+{
+  size_t maxRows = 0;
+  // Approximate size of the values, text and blob bytes or 8 bytes for other values
+  size_t maxBytes = 0;
+};
+
+/**
+ * Options which can be provided for a single query execution
+ */
+struct QuickQueryOptions
+{
+  QuickResultFormat resultFormat = RESULT_ROWS;
+  // Columns requested for RESULT_TYPED_COLUMNS, in the order they were provided
+  vector<pair<string, QuickTypedColumnType>> typedColumns;
+  QueryLimits limits;
+};
+
 /**
  * Various structs to help with the results of the SQLite operations
  */
@@ -78,12 +175,23 @@ struct SequelLiteralUpdateResult
   int affectedRows;
 };
 
+/**
+ * Execution details of consecutive batch commands which share the same SQL
+ */
+struct SequelBatchGroupResult
+{
+  int commands;
+  int affectedRows;
+  double durationMs;
+};
+
 struct SequelBatchOperationResult
 {
   ResultType type;
   string message;
   int affectedRows;
   int commands;
+  vector<SequelBatchGroupResult> groups;
 };
 
 /**
@@ -97,18 +205,65 @@ struct QuickColumnMetadata
 };
 
 /**
- * Fill the target vector with parsed parameters
+ * Fill the target vector with parsed parameters. Values are created in place,
+ * strings are moved from the JSI conversion.
  * */
 void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &args, vector<QuickValue> *target);
 
+/**
+ * Parses the optional query options object provided from JavaScript
+ * */
+QuickQueryOptions jsiQueryOptions(jsi::Runtime &rt, jsi::Value const &options);
+
 QuickValue createNullQuickValue();
 QuickValue createBooleanQuickValue(bool value);
-QuickValue createTextQuickValue(string value);
+QuickValue createTextQuickValue(string &&value);
+QuickValue createTextQuickValue(const char *value, size_t length);
 QuickValue createIntegerQuickValue(int value);
 QuickValue createIntegerQuickValue(double value);
 QuickValue createInt64QuickValue(long long value);
 QuickValue createDoubleQuickValue(double value);
-QuickValue createArrayBufferQuickValue(uint8_t *arrayBufferValue, size_t arrayBufferSize);
-jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, vector<map<string, QuickValue>> *results, vector<QuickColumnMetadata> *metadata);
+/**
+ * Copies the bytes into a natively owned buffer
+ */
+QuickValue createArrayBufferQuickValue(const uint8_t *arrayBufferValue, size_t arrayBufferSize);
+/**
+ * Creates an ArrayBuffer backed by the native buffer if the runtime supports it, otherwise the bytes are copied
+ */
+jsi::Value createJSIArrayBuffer(jsi::Runtime &rt, shared_ptr<QuickArrayBuffer> const &buffer);
+jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, QuickQueryResult *results, vector<QuickColumnMetadata> *metadata);
+
+/**
+ * Creates a result with `columns` and a flat row-major `values` array instead of an object per row
+ */
+jsi::Value createCompactQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, QuickQueryResult *results, vector<QuickColumnMetadata> *metadata);
+
+/**
+ * Creates a result with a `Float64Array` or `Int32Array` and a null bitmap for each typed column.
+ * The column buffers are moved out of the results.
+ */
+jsi::Value createTypedColumnsQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, QuickQueryResult *results, vector<QuickColumnMetadata> *metadata);
+
+/**
+ * Rows of a result set which keeps the native values and only creates the JS object of a row once it is read.
+ * Provides `length`, `item(index)` and `_array`, which converts all rows each time it is read.
+ */
+class QuickRowsHostObject : public jsi::HostObject
+{
+public:
+  QuickRowsHostObject(shared_ptr<QuickQueryResult> results);
+
+  jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &name) override;
+  vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override;
+
+private:
+  shared_ptr<QuickQueryResult> results;
+};
+
+/**
+ * Creates a result with a `rows` host object instead of converting all rows on the JS thread.
+ * The results are shared with the host object.
+ */
+jsi::Value createLazyRowsQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, shared_ptr<QuickQueryResult> results, vector<QuickColumnMetadata> *metadata);
 
 #endif /* JSIHelper_h */
@@ -0,0 +1,159 @@
+#include "PreparedStatementCache.h"
+
+/**
+ * Flags statements which change the schema or the set of attached databases
+ * while they are being prepared. Access is never denied.
+ */
+int statementCacheAuthorizer(void *cache, int actionCode, const char *,
+                             const char *, const char *, const char *) {
+  auto statementCache = (PreparedStatementCache *)cache;
+  if (!statementCache->isPreparing) {
+    return SQLITE_OK;
+  }
+
+  switch (actionCode) {
+  case SQLITE_CREATE_INDEX:
+  case SQLITE_CREATE_TABLE:
+  case SQLITE_CREATE_TEMP_INDEX:
+  case SQLITE_CREATE_TEMP_TABLE:
+  case SQLITE_CREATE_TEMP_TRIGGER:
+  case SQLITE_CREATE_TEMP_VIEW:
+  case SQLITE_CREATE_TRIGGER:
+  case SQLITE_CREATE_VIEW:
+  case SQLITE_CREATE_VTABLE:
+  case SQLITE_DROP_INDEX:
+  case SQLITE_DROP_TABLE:
+  case SQLITE_DROP_TEMP_INDEX:
+  case SQLITE_DROP_TEMP_TABLE:
+  case SQLITE_DROP_TEMP_TRIGGER:
+  case SQLITE_DROP_TEMP_VIEW:
+  case SQLITE_DROP_TRIGGER:
+  case SQLITE_DROP_VIEW:
+  case SQLITE_DROP_VTABLE:
+  case SQLITE_ALTER_TABLE:
+  case SQLITE_ATTACH:
+  case SQLITE_DETACH:
+    statementCache->preparedInvalidatesSchema = true;
+    break;
+  default:
+    break;
+  }
+
+  return SQLITE_OK;
+}
+
+PreparedStatementCache::PreparedStatementCache(unsigned int capacity)
+    : capacity(capacity), connection(nullptr), isPreparing(false),
+      preparedInvalidatesSchema(false), hits(0), misses(0) {}
+
+PreparedStatementCache::~PreparedStatementCache() {
+  clear();
+  for (auto &entry : inUse) {
+    sqlite3_finalize(entry.first);
+  }
+  inUse.clear();
+}
+
+void PreparedStatementCache::attach(sqlite3 *db) {
+  connection = db;
+  sqlite3_set_authorizer(db, statementCacheAuthorizer, (void *)this);
+}
+
+int PreparedStatementCache::acquire(std::string const &sql,
+                                    sqlite3_stmt **statement) {
+  auto cached = index.find(sql);
+  if (cached != index.end()) {
+    hits++;
+    auto entry = cached->second;
+    *statement = entry->statement;
+    inUse[entry->statement] = std::move(*entry);
+    entries.erase(entry);
+    index.erase(cached);
+    return SQLITE_OK;
+  }
+
+  misses++;
+  isPreparing = true;
+  preparedInvalidatesSchema = false;
+  // Statements which are cached are expected to be reused
+  int status = sqlite3_prepare_v3(connection, sql.c_str(), -1,
+                                  capacity > 0 ? SQLITE_PREPARE_PERSISTENT : 0,
+                                  statement, NULL);
+  isPreparing = false;
+
+  if (status == SQLITE_OK && *statement != nullptr) {
+    inUse[*statement] = CacheEntry{
+        .sql = sql,
+        .statement = *statement,
+        .invalidatesSchema = preparedInvalidatesSchema,
+    };
+  }
+
+  return status;
+}
+
+void PreparedStatementCache::release(sqlite3_stmt *statement) {
+  if (statement == nullptr) {
+    return;
+  }
+
+  auto checkedOut = inUse.find(statement);
+  if (checkedOut == inUse.end()) {
+    sqlite3_finalize(statement);
+    return;
+  }
+
+  CacheEntry entry = std::move(checkedOut->second);
+  inUse.erase(checkedOut);
+
+  if (entry.invalidatesSchema) {
+    sqlite3_finalize(statement);
+    clear();
+    return;
+  }
+
+  // The same SQL could have been checked out twice, only keep one copy
+  if (capacity == 0 || index.count(entry.sql) > 0) {
+    sqlite3_finalize(statement);
+    return;
+  }
+
+  sqlite3_reset(statement);
+  sqlite3_clear_bindings(statement);
+
+  entries.push_front(std::move(entry));
+  index[entries.front().sql] = entries.begin();
+  evict();
+}
+
+void PreparedStatementCache::clear() {
+  for (auto &entry : entries) {
+    sqlite3_finalize(entry.statement);
+  }
+  entries.clear();
+  index.clear();
+}
+
+void PreparedStatementCache::setCapacity(unsigned int capacity) {
+  this->capacity = capacity;
+  evict();
+}
+
+unsigned int PreparedStatementCache::getCapacity() const { return capacity; }
+
+size_t PreparedStatementCache::size() const { return entries.size(); }
+
+unsigned long PreparedStatementCache::getHits() const { return hits; }
+
+unsigned long PreparedStatementCache::getMisses() const { return misses; }
+
+// ===================== Private ===============
+
+void PreparedStatementCache::evict() {
+  while (entries.size() > capacity) {
+    auto &last = entries.back();
+    index.erase(last.sql);
+    sqlite3_finalize(last.statement);
+    entries.pop_back();
+  }
+}
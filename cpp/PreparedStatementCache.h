@@ -0,0 +1,94 @@
+#include "sqlite3.h"
+#include <atomic>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#ifndef PreparedStatementCache_h
+#define PreparedStatementCache_h
+
+#define DEFAULT_STATEMENT_CACHE_SIZE 32
+
+/**
+ * Bounded LRU cache of prepared statements for a single SQLite connection.
+ *
+ * Statements are keyed by their SQL text. A statement is checked out with
+ * `acquire` and must be handed back with `release` once the caller is done
+ * stepping it. Released statements are reset and their bindings cleared before
+ * they are made available again.
+ *
+ * Statements which change the schema (CREATE, DROP, ALTER, ATTACH, DETACH...)
+ * are detected with an authorizer while they are prepared. Releasing such a
+ * statement clears the cache. Statements cached on other connections do not
+ * need to be cleared, SQLite transparently re-prepares them on the next step.
+ *
+ * The cache is not thread safe. It should only be used from the worker thread
+ * of the connection which owns it, or while that worker is idle.
+ */
+class PreparedStatementCache {
+private:
+  struct CacheEntry {
+    std::string sql;
+    sqlite3_stmt *statement;
+    bool invalidatesSchema;
+  };
+
+  unsigned int capacity;
+  sqlite3 *connection;
+
+  // Most recently used entries are at the front of the list
+  std::list<CacheEntry> entries;
+  std::unordered_map<std::string, std::list<CacheEntry>::iterator> index;
+  // Statements which are currently checked out
+  std::unordered_map<sqlite3_stmt *, CacheEntry> inUse;
+
+  // Set by the authorizer while a statement is being prepared
+  bool isPreparing;
+  bool preparedInvalidatesSchema;
+
+  std::atomic<unsigned long> hits;
+  std::atomic<unsigned long> misses;
+
+public:
+  PreparedStatementCache(unsigned int capacity = DEFAULT_STATEMENT_CACHE_SIZE);
+  ~PreparedStatementCache();
+
+  friend int statementCacheAuthorizer(void *cache, int actionCode,
+                                      const char *, const char *,
+                                      const char *, const char *);
+
+  /**
+   * Binds the cache to a connection. This registers an authorizer on the
+   * connection in order to detect schema changes.
+   */
+  void attach(sqlite3 *db);
+
+  /**
+   * Returns a prepared statement for the SQL, preparing it if it is not
+   * cached. The statement pointer might be NULL for empty SQL.
+   * @returns the SQLite result code of the prepare operation
+   */
+  int acquire(std::string const &sql, sqlite3_stmt **statement);
+
+  /**
+   * Hands a statement obtained from `acquire` back to the cache.
+   */
+  void release(sqlite3_stmt *statement);
+
+  /**
+   * Finalizes all cached statements which are not checked out.
+   */
+  void clear();
+
+  void setCapacity(unsigned int capacity);
+
+  unsigned int getCapacity() const;
+  size_t size() const;
+  unsigned long getHits() const;
+  unsigned long getMisses() const;
+
+private:
+  void evict();
+};
+
+#endif
@@ -0,0 +1,40 @@
+#include "SharedWorkerPool.h"
+#include "ConnectionState.h"
+#include <algorithm>
+
+SharedWorkerPool::SharedWorkerPool(unsigned int threadCount) {
+  for (unsigned int i = 0; i < threadCount; i++) {
+    threads.emplace_back(&SharedWorkerPool::work, this);
+  }
+}
+
+SharedWorkerPool &SharedWorkerPool::getInstance() {
+  // Never destroyed, the threads don't exit
+  static SharedWorkerPool *instance = new SharedWorkerPool(
+      std::clamp(std::thread::hardware_concurrency(),
+                 (unsigned int)MIN_SHARED_WORKER_THREADS,
+                 (unsigned int)MAX_SHARED_WORKER_THREADS));
+  return *instance;
+}
+
+void SharedWorkerPool::schedule(ConnectionState *state) {
+  {
+    std::lock_guard<std::mutex> g(mutex);
+    readyConnections.push_back(state);
+  }
+  connectionReady.notify_one();
+}
+
+void SharedWorkerPool::work() {
+  while (true) {
+    ConnectionState *state;
+    {
+      std::unique_lock<std::mutex> g(mutex);
+      connectionReady.wait(g, [&] { return !readyConnections.empty(); });
+      state = readyConnections.front();
+      readyConnections.pop_front();
+    }
+    // Schedules the connection again if it has more tasks
+    state->runSharedWork();
+  }
+}
@@ -0,0 +1,50 @@
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef SharedWorkerPool_h
+#define SharedWorkerPool_h
+
+// Bounds of the number of shared worker threads, which defaults to the number
+// of cores
+#define MIN_SHARED_WORKER_THREADS 2
+#define MAX_SHARED_WORKER_THREADS 4
+
+class ConnectionState;
+
+/**
+ * Threads shared by all connections which are opened with shared workers,
+ * instead of a thread per connection.
+ *
+ * A connection with queued tasks is scheduled once. A worker takes it from
+ * the ready queue and runs a batch of its tasks, then schedules it again if
+ * more tasks are queued. A connection is never run by two workers at the same
+ * time, so its tasks keep their order.
+ */
+class SharedWorkerPool {
+private:
+  std::mutex mutex;
+  std::condition_variable connectionReady;
+  std::deque<ConnectionState *> readyConnections;
+  std::vector<std::thread> threads;
+
+  SharedWorkerPool(unsigned int threadCount);
+  void work();
+
+public:
+  /**
+   * The pool is started once it is used first and runs until the process
+   * exits
+   */
+  static SharedWorkerPool &getInstance();
+
+  /**
+   * Queues the connection to run its tasks. Must be called at most once until
+   * the connection has run.
+   */
+  void schedule(ConnectionState *state);
+};
+
+#endif
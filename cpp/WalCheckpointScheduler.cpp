@@ -0,0 +1,98 @@
+#include "WalCheckpointScheduler.h"
+#include <chrono>
+
+WalCheckpointScheduler::WalCheckpointScheduler()
+    : enabled(false), thresholdFrames(0), busyTimeoutMs(0), walFrames(0),
+      pending(false), truncateRequested(false),
+      incompletePassiveCheckpoints(0) {}
+
+void WalCheckpointScheduler::enable(int thresholdFrames, int busyTimeoutMs) {
+  this->thresholdFrames = thresholdFrames;
+  this->busyTimeoutMs = busyTimeoutMs;
+  enabled = true;
+}
+
+bool WalCheckpointScheduler::isEnabled() const { return enabled; }
+
+void WalCheckpointScheduler::onWalCommit(int frames) {
+  walFrames = frames;
+  if (frames >= thresholdFrames) {
+    pending = true;
+  }
+}
+
+void WalCheckpointScheduler::request(bool truncate) {
+  if (truncate) {
+    truncateRequested = true;
+  }
+  pending = true;
+}
+
+bool WalCheckpointScheduler::takePending() {
+  return enabled && pending.exchange(false);
+}
+
+bool WalCheckpointScheduler::isOverdue() const {
+  return enabled &&
+         walFrames >= thresholdFrames * OVERDUE_CHECKPOINT_THRESHOLD_FACTOR;
+}
+
+void WalCheckpointScheduler::checkpoint(sqlite3 *db) {
+  bool truncate = truncateRequested.exchange(false) ||
+                  incompletePassiveCheckpoints >=
+                      MAX_INCOMPLETE_PASSIVE_CHECKPOINTS;
+  int mode = truncate ? SQLITE_CHECKPOINT_TRUNCATE : SQLITE_CHECKPOINT_PASSIVE;
+
+  int logFrames = 0;
+  int checkpointedFrames = 0;
+  auto start = std::chrono::steady_clock::now();
+  if (truncate && busyTimeoutMs > 0) {
+    // Queued writers would wait for the entire busy timeout while readers
+    // keep using the WAL. Without a busy handler a TRUNCATE checkpoint
+    // proceeds like a PASSIVE one and reports SQLITE_BUSY.
+    sqlite3_busy_timeout(db, 0);
+  }
+  int status = sqlite3_wal_checkpoint_v2(db, nullptr, mode, &logFrames,
+                                         &checkpointedFrames);
+  if (truncate && busyTimeoutMs > 0) {
+    sqlite3_busy_timeout(db, busyTimeoutMs);
+  }
+  std::chrono::duration<double, std::milli> duration =
+      std::chrono::steady_clock::now() - start;
+
+  bool isComplete = status == SQLITE_OK && checkpointedFrames >= logFrames;
+  if (isComplete) {
+    incompletePassiveCheckpoints = 0;
+  } else if (!truncate) {
+    // A busy TRUNCATE checkpoint keeps escalating until it succeeds
+    incompletePassiveCheckpoints++;
+  }
+  // A truncated WAL is empty, otherwise the WAL is reset by the next writer
+  walFrames =
+      (status == SQLITE_OK && truncate) || logFrames < 0 ? 0 : logFrames;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  stats.checkpoints++;
+  if (truncate) {
+    stats.truncateCheckpoints++;
+  } else {
+    stats.passiveCheckpoints++;
+  }
+  if (!isComplete) {
+    stats.busyCheckpoints++;
+  }
+  if (checkpointedFrames > 0) {
+    stats.framesCheckpointed += checkpointedFrames;
+  }
+  stats.totalMs += duration.count();
+  if (duration.count() > stats.maxMs) {
+    stats.maxMs = duration.count();
+  }
+}
+
+CheckpointStatsSnapshot WalCheckpointScheduler::snapshot() {
+  std::lock_guard<std::mutex> lock(mutex);
+  CheckpointStatsSnapshot result = stats;
+  result.walFrames = walFrames;
+  return result;
+}
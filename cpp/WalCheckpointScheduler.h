@@ -0,0 +1,99 @@
+#include "sqlite3.h"
+#include <atomic>
+#include <mutex>
+
+#ifndef WalCheckpointScheduler_h
+#define WalCheckpointScheduler_h
+
+// Consecutive passive checkpoints which could not checkpoint the entire WAL
+// before escalating to a TRUNCATE checkpoint
+#define MAX_INCOMPLETE_PASSIVE_CHECKPOINTS 3
+// Multiple of the threshold after which a checkpoint runs ahead of queued
+// writers instead of waiting for the write connection to be idle
+#define OVERDUE_CHECKPOINT_THRESHOLD_FACTOR 4
+
+/**
+ * Checkpoint measurements of a database
+ */
+struct CheckpointStatsSnapshot {
+  unsigned long checkpoints = 0;
+  unsigned long passiveCheckpoints = 0;
+  unsigned long truncateCheckpoints = 0;
+  // Checkpoints which could not complete because of readers or writers
+  unsigned long busyCheckpoints = 0;
+  unsigned long framesCheckpointed = 0;
+  // Frames in the WAL after the last commit or checkpoint
+  int walFrames = 0;
+  double totalMs = 0;
+  double maxMs = 0;
+};
+
+/**
+ * Runs WAL checkpoints while the write connection is idle, instead of inline
+ * with the commit which crosses the autocheckpoint threshold.
+ *
+ * Commits are reported from the WAL hook of the write connection. Once the WAL
+ * has grown past the threshold a checkpoint is pending, the connection pool
+ * runs it before the write connection is released. Under steady write traffic
+ * the connection is never idle, once the checkpoint is overdue it runs before
+ * the next queued writer. Checkpoints are PASSIVE and escalate to TRUNCATE if
+ * they repeatedly can't checkpoint the entire WAL.
+ */
+class WalCheckpointScheduler {
+private:
+  bool enabled;
+  int thresholdFrames;
+  // Busy timeout of the write connection, restored after TRUNCATE checkpoints
+  int busyTimeoutMs;
+  std::atomic<int> walFrames;
+  std::atomic<bool> pending;
+  std::atomic<bool> truncateRequested;
+  // Only accessed from the write connection's worker thread
+  unsigned int incompletePassiveCheckpoints;
+
+  std::mutex mutex;
+  CheckpointStatsSnapshot stats;
+
+public:
+  WalCheckpointScheduler();
+
+  /**
+   * Enables the scheduler. A pending checkpoint is flagged once the WAL has
+   * `thresholdFrames` frames. `busyTimeoutMs` is the busy timeout configured
+   * on the write connection.
+   */
+  void enable(int thresholdFrames, int busyTimeoutMs);
+  bool isEnabled() const;
+
+  /**
+   * Reports the size of the WAL after a commit. Called from the WAL hook.
+   */
+  void onWalCommit(int frames);
+
+  /**
+   * Flags a checkpoint, e.g. when the app moves to the background
+   */
+  void request(bool truncate);
+
+  /**
+   * Returns true and clears the flag if a checkpoint is pending
+   */
+  bool takePending();
+
+  /**
+   * True if the WAL has grown far enough past the threshold that the
+   * checkpoint should not wait for the write connection to be idle
+   */
+  bool isOverdue() const;
+
+  /**
+   * Runs a checkpoint. Must be called from the write connection's worker
+   * thread while it holds the write lock. TRUNCATE checkpoints don't wait for
+   * readers, they are counted as busy if readers are still using the WAL.
+   */
+  void checkpoint(sqlite3 *db);
+
+  CheckpointStatsSnapshot snapshot();
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "WatchedQueries.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+static std::string toLowerCase(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return value;
+}
+
+static int collectReadTables(void *context, int action, const char *table,
+                             const char *column, const char *database,
+                             const char *trigger) {
+  if (action == SQLITE_READ && table != nullptr) {
+    static_cast<std::set<std::string> *>(context)->insert(toLowerCase(table));
+  }
+  return SQLITE_OK;
+}
+
+SQLiteOPResult readStatementTables(sqlite3 *db,
+                                   PreparedStatementCache *statementCache,
+                                   std::string const &sql,
+                                   std::set<std::string> *tables) {
+  sqlite3_set_authorizer(db, collectReadTables, tables);
+  sqlite3_stmt *statement = nullptr;
+  int status = sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, nullptr);
+  // The cache detects schema changes with its own authorizer
+  statementCache->attach(db);
+
+  if (status != SQLITE_OK) {
+    return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "[react-native-quick-sqlite] SQL execution error: " +
+                        std::string(sqlite3_errmsg(db)),
+    };
+  }
+  sqlite3_finalize(statement);
+  return SQLiteOPResult{.type = SQLiteOk};
+}
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static void hashBytes(uint64_t *hash, const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; i++) {
+    *hash = (*hash ^ bytes[i]) * FNV_PRIME;
+  }
+}
+
+uint64_t hashQueryResult(QuickQueryResult const &results) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  for (auto const &columnName : results.columnNames) {
+    hashBytes(&hash, columnName.data(), columnName.size() + 1);
+  }
+  hashBytes(&hash, &results.rowCount, sizeof(results.rowCount));
+
+  for (auto const &value : results.values) {
+    // The type is part of the hash, e.g. 1 and '1' are different values
+    hashBytes(&hash, &value.dataType, sizeof(value.dataType));
+    switch (value.dataType) {
+    case TEXT: {
+      auto const &text = value.textValue();
+      size_t length = text.size();
+      hashBytes(&hash, &length, sizeof(length));
+      hashBytes(&hash, text.data(), length);
+      break;
+    }
+    case INTEGER:
+    case DOUBLE: {
+      double number = value.doubleOrIntValue();
+      hashBytes(&hash, &number, sizeof(number));
+      break;
+    }
+    case INT64: {
+      long long number = value.int64Value();
+      hashBytes(&hash, &number, sizeof(number));
+      break;
+    }
+    case BOOLEAN: {
+      int boolean = value.booleanValue();
+      hashBytes(&hash, &boolean, sizeof(boolean));
+      break;
+    }
+    case ARRAY_BUFFER: {
+      auto const &buffer = value.arrayBufferValue();
+      size_t length = buffer->size();
+      hashBytes(&hash, &length, sizeof(length));
+      hashBytes(&hash, buffer->data(), length);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return hash;
+}
+
+bool hasUpdatedTable(std::set<std::string> const &tables,
+                     std::vector<TableUpdates> const &updates) {
+  for (auto const &update : updates) {
+    if (tables.count(toLowerCase(update.table)) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,35 @@
+#include "ConnectionPool.h"
+#include "JSIHelper.h"
+#include "sqlite3.h"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifndef WatchedQueries_h
+#define WatchedQueries_h
+
+/**
+ * Collects the tables which a statement reads, including the tables of views,
+ * with an authorizer while the statement is prepared. Table names are lower
+ * case. The authorizer of the statement cache is restored afterwards. Must be
+ * called on the worker thread of the connection.
+ */
+SQLiteOPResult readStatementTables(sqlite3 *db,
+                                   PreparedStatementCache *statementCache,
+                                   std::string const &sql,
+                                   std::set<std::string> *tables);
+
+/**
+ * Hashes the column names and values of a result set. Re-runs of a watched
+ * query with the same hash are not reported.
+ */
+uint64_t hashQueryResult(QuickQueryResult const &results);
+
+/**
+ * Checks if any of the tables was updated
+ */
+bool hasUpdatedTable(std::set<std::string> const &tables,
+                     std::vector<TableUpdates> const &updates);
+
+#endif
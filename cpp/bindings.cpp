@@ -1,13 +1,22 @@
 #include "bindings.h"
 #include "ConnectionPool.h"
 #include "JSIHelper.h"
+#include "WatchedQueries.h"
+#include "fileUtils.h"
 #include "logs.h"
 #include "macros.h"
 #include "sqlbatchexecutor.h"
 #include "sqlite3.h"
+#include "sqliteBackup.h"
 #include "sqliteBridge.h"
 #include "sqliteExecute.h"
+#include "sqliteSearch.h"
+#include "sqliteSession.h"
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -33,51 +42,389 @@ int init_powersync_sqlite_plugin() {
   return result;
 }
 
-void osp::clearState() { sqliteCloseAll(); }
+void osp::releaseMemory() {
+  if (invoker == nullptr) {
+    return;
+  }
+  // Open databases are only accessed from the JS thread
+  invoker->invokeAsync([] { sqliteReleaseAllMemory(); });
+}
 
 /**
- * Callback handler for SQLite table updates
+ * Rejects a promise with a JS Error. Must be called on the JS thread.
  */
-void updateTableHandler(void *voidDBName, int opType, char const *dbName,
-                        char const *tableName, sqlite3_int64 rowId) {
-  /**
-   * No DB operations should occur when this callback is fired from SQLite.
-   * This function triggers an async invocation to call watch callbacks,
-   * avoiding holding SQLite up.
-   */
-  invoker->invokeAsync([voidDBName, opType, dbName, tableName, rowId] {
+void rejectWithError(jsi::Runtime &rt, std::shared_ptr<jsi::Value> reject,
+                     std::string const &message) {
+  auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+  auto error = errorCtr.callAsConstructor(
+      rt, jsi::String::createFromUtf8(rt, message));
+  reject->asObject(rt).asFunction(rt).call(rt, error);
+}
+
+/**
+ * Rejects the promise of a native task which was dropped because the database
+ * closed. Can be called from any thread.
+ */
+TaskRejection createTaskRejection(jsi::Runtime &rt,
+                                  std::shared_ptr<jsi::Value> reject) {
+  return [&rt, reject](std::string const &message) {
+    invoker->invokeAsync(
+        [&rt, reject, message] { rejectWithError(rt, reject, message); });
+  };
+}
+
+/**
+ * Creates a task which executes a statement and resolves the promise with its
+ * result
+ */
+ConnectionTask createExecuteTask(jsi::Runtime &rt, std::string const query,
+                                 std::shared_ptr<vector<QuickValue>> params,
+                                 QuickQueryOptions const options,
+                                 std::shared_ptr<jsi::Value> resolve,
+                                 std::shared_ptr<jsi::Value> reject) {
+  return [&rt, query, params, options, resolve,
+          reject](ConnectionState *state) {
     try {
-      // Sqlite 3 just returns main as the db name if no other DBs are attached
-      auto global = runtime->global();
-      jsi::Function handlerFunction =
-          global.getPropertyAsFunction(*runtime, "triggerUpdateHook");
-
-      std::string actualDBName = std::string((char *)voidDBName);
-      auto jsiDbName = jsi::String::createFromAscii(*runtime, actualDBName);
-      auto jsiTableName = jsi::String::createFromAscii(*runtime, tableName);
-      auto jsiOpType = jsi::Value(opType);
-      auto jsiRowId =
-          jsi::String::createFromAscii(*runtime, std::to_string(rowId));
-      handlerFunction.call(*runtime, move(jsiDbName), move(jsiTableName),
-                           move(jsiOpType), move(jsiRowId));
-    } catch (jsi::JSINativeException e) {
-      std::cout << e.what() << std::endl;
-    } catch (...) {
-      std::cout << "Unknown error" << std::endl;
+      auto results = make_shared<QuickQueryResult>();
+      results->int64Values = state->int64Results;
+      for (auto &column : options.typedColumns) {
+        results->typedColumns.push_back(
+            QuickTypedColumn{.name = column.first, .type = column.second});
+      }
+      auto metadata = make_shared<vector<QuickColumnMetadata>>();
+      auto stats = state->stats;
+      QueryStats queryStats;
+      auto status = sqliteExecuteWithDB(
+          state->connection, query, params.get(), results.get(),
+          metadata.get(), &state->statementCache,
+          stats->isEnabled() ? &queryStats : nullptr, &options.limits);
+      stats->recordQuery(queryStats);
+      invoker->invokeAsync([&rt, results, metadata, options, stats,
+                            status_copy = move(status), resolve, reject] {
+        if (status_copy.type == SQLiteOk) {
+          auto start = std::chrono::steady_clock::now();
+          jsi::Value jsiResult;
+          switch (options.resultFormat) {
+          case RESULT_COMPACT:
+            jsiResult = createCompactQueryExecutionResult(
+                rt, status_copy, results.get(), metadata.get());
+            break;
+          case RESULT_TYPED_COLUMNS:
+            jsiResult = createTypedColumnsQueryExecutionResult(
+                rt, status_copy, results.get(), metadata.get());
+            break;
+          case RESULT_LAZY_ROWS:
+            jsiResult = createLazyRowsQueryExecutionResult(
+                rt, status_copy, results, metadata.get());
+            break;
+          default:
+            jsiResult = createSequelQueryExecutionResult(
+                rt, status_copy, results.get(), metadata.get());
+          }
+          std::chrono::duration<double, std::milli> marshalling =
+              std::chrono::steady_clock::now() - start;
+          stats->recordMarshalling(marshalling.count());
+          resolve->asObject(rt).asFunction(rt).call(rt, move(jsiResult));
+        } else {
+          rejectWithError(rt, reject, status_copy.errorMessage);
+        }
+      });
+    } catch (std::exception &exc) {
+      std::string message = exc.what();
+      invoker->invokeAsync(
+          [&rt, message, reject] { rejectWithError(rt, reject, message); });
     }
-  });
+  };
+}
+
+/**
+ * Reads an optional number property, the property must be a number if present
+ */
+static std::optional<long long> jsiOptionalNumber(jsi::Runtime &rt,
+                                                  jsi::Object const &options,
+                                                  const char *name) {
+  auto property = options.getProperty(rt, name);
+  if (property.isUndefined() || property.isNull()) {
+    return std::nullopt;
+  }
+  if (!property.isNumber()) {
+    throw jsi::JSError(rt, std::string("[react-native-quick-sqlite][open] ") +
+                               name + " must be a number");
+  }
+  return (long long)property.getNumber();
+}
+
+/**
+ * Parses the connection options of the open options object
+ */
+static ConnectionOptions jsiConnectionOptions(jsi::Runtime &rt,
+                                              jsi::Object const &options) {
+  ConnectionOptions result;
+
+  auto reportRowIds = options.getProperty(rt, "reportRowIds");
+  if (reportRowIds.isBool()) {
+    result.reportRowIds = reportRowIds.getBool();
+  }
+
+  auto bigIntResults = options.getProperty(rt, "bigIntResults");
+  if (bigIntResults.isBool()) {
+    result.int64Results = bigIntResults.getBool();
+  }
+
+  auto backgroundCheckpoints =
+      options.getProperty(rt, "backgroundCheckpoints");
+  if (backgroundCheckpoints.isBool()) {
+    result.backgroundCheckpoints = backgroundCheckpoints.getBool();
+  }
+
+  auto noMutex = options.getProperty(rt, "noMutex");
+  if (noMutex.isBool()) {
+    result.noMutex = noMutex.getBool();
+  }
+
+  result.cacheSize = jsiOptionalNumber(rt, options, "cacheSize");
+  result.mmapSize = jsiOptionalNumber(rt, options, "mmapSize");
+  result.walAutocheckpoint =
+      jsiOptionalNumber(rt, options, "walAutocheckpoint");
+  auto busyTimeout = jsiOptionalNumber(rt, options, "busyTimeout");
+  if (busyTimeout.has_value()) {
+    result.busyTimeout = (int)*busyTimeout;
+  }
+  auto lazyReadConnections = options.getProperty(rt, "lazyReadConnections");
+  if (lazyReadConnections.isBool()) {
+    result.lazyReadConnections = lazyReadConnections.getBool();
+  }
+  auto sharedWorkers = options.getProperty(rt, "sharedWorkers");
+  if (sharedWorkers.isBool()) {
+    result.sharedWorkers = sharedWorkers.getBool();
+  }
+  auto readThreadIdleTimeoutMs =
+      jsiOptionalNumber(rt, options, "readThreadIdleTimeoutMs");
+  if (readThreadIdleTimeoutMs.has_value()) {
+    result.readThreadIdleTimeoutMs = (int)*readThreadIdleTimeoutMs;
+  }
+
+  auto tempStore = options.getProperty(rt, "tempStore");
+  if (tempStore.isString()) {
+    auto value = tempStore.asString(rt).utf8(rt);
+    if (value == "default") {
+      result.tempStore = TEMP_STORE_DEFAULT;
+    } else if (value == "file") {
+      result.tempStore = TEMP_STORE_FILE;
+    } else if (value == "memory") {
+      result.tempStore = TEMP_STORE_MEMORY;
+    } else {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][open] tempStore "
+                             "must be one of default, file or memory");
+    }
+  }
+
+  return result;
 }
 
 /**
- * Callback handler for SQLite transaction updates
+ * Shared state of independent read queries which are executed in parallel.
+ * Each query writes to its own slot, the last query to complete reports all
+ * results.
+ */
+struct ParallelReads {
+  vector<QuickQueryArguments> queries;
+  vector<SQLiteOPResult> statuses;
+  vector<QuickQueryResult> results;
+  vector<vector<QuickColumnMetadata>> metadata;
+  std::atomic<size_t> remaining;
+
+  ParallelReads(vector<QuickQueryArguments> queries)
+      : queries(std::move(queries)), statuses(this->queries.size()),
+        results(this->queries.size()), metadata(this->queries.size()),
+        remaining(this->queries.size()) {}
+};
+
+/**
+ * A statement of a pipeline. Only accessed by the worker until the pipeline
+ * has finished.
  */
-void transactionFinalizerHandler(const TransactionCallbackPayload *payload) {
+struct PipelineStatement {
+  SQLiteOPResult status;
+  QuickQueryResult results;
+  vector<QuickColumnMetadata> metadata;
+};
+
+/**
+ * Shared state of statements which are queued in a lock context without
+ * waiting for the previous results. The statements run in a savepoint, which
+ * is rolled back after the first failure. Later statements are skipped.
+ */
+struct Pipeline {
+  string dbName;
+  ConnectionLockId contextId;
+  string savepoint;
+  // Only modified on the JS thread
+  vector<shared_ptr<PipelineStatement>> statements;
+  bool isFinished = false;
+  // Only modified on the worker thread
+  bool isStarted = false;
+  bool isFailed = false;
+  string errorMessage;
+};
+
+std::atomic<unsigned long> nextPipelineId(0);
+
+/**
+ * A query which is re-run on a read connection once a committed transaction
+ * updated one of the tables it reads. Only accessed on the JS thread, tasks
+ * reference it by its watch ID.
+ */
+struct WatchedQuery {
+  string dbName;
+  string sql;
+  // Bound again for every run, runs never overlap
+  shared_ptr<vector<QuickValue>> params;
+  shared_ptr<jsi::Value> onResult;
+  shared_ptr<jsi::Value> onError;
+  // Read once, with the first run
+  std::set<std::string> tables;
+  bool hasTables = false;
+  uint64_t lastHash = 0;
+  bool hasResult = false;
+  bool isRunning = false;
+  // Set if the tables were updated while the query was running
+  bool isStale = false;
+};
+
+// Never destroyed, the callbacks must not be released after the runtime
+std::map<unsigned int, shared_ptr<WatchedQuery>> &watchedQueries =
+    *new std::map<unsigned int, shared_ptr<WatchedQuery>>();
+unsigned int nextWatchId = 1;
+
+void osp::clearState() {
+  watchedQueries.clear();
+  sqliteCloseAll();
+}
+
+/**
+ * Runs a watched query and reports the result if it changed. Must be called
+ * on the JS thread. Results of queries which are no longer watched are
+ * dropped.
+ */
+SQLiteOPResult runWatchedQuery(jsi::Runtime &rt, unsigned int watchId,
+                               shared_ptr<WatchedQuery> query) {
+  if (query->isRunning) {
+    // Runs again once the current run completed
+    query->isStale = true;
+    return SQLiteOPResult{.type = SQLiteOk};
+  }
+  query->isRunning = true;
+  query->isStale = false;
+
+  const bool needsTables = !query->hasTables;
+  // The task is released on the worker thread, it can't reference the JS
+  // callbacks
+  auto task = [&rt, watchId, sql = query->sql, params = query->params,
+               needsTables](ConnectionState *state) {
+    auto tables = make_shared<std::set<std::string>>();
+    auto results = make_shared<QuickQueryResult>();
+    auto metadata = make_shared<vector<QuickColumnMetadata>>();
+    results->int64Values = state->int64Results;
+
+    SQLiteOPResult status = {.type = SQLiteOk};
+    if (needsTables) {
+      status = readStatementTables(state->connection, &state->statementCache,
+                                   sql, tables.get());
+    }
+    if (status.type == SQLiteOk) {
+      QueryStats queryStats;
+      status = sqliteExecuteWithDB(
+          state->connection, sql, params.get(), results.get(), metadata.get(),
+          &state->statementCache,
+          state->stats->isEnabled() ? &queryStats : nullptr);
+      state->stats->recordQuery(queryStats);
+    }
+    // Results are only converted on the JS thread if they changed
+    const uint64_t hash =
+        status.type == SQLiteOk ? hashQueryResult(*results) : 0;
+
+    invoker->invokeAsync([&rt, watchId, needsTables, status, tables, results,
+                          metadata, hash] {
+      auto it = watchedQueries.find(watchId);
+      if (it == watchedQueries.end()) {
+        return;
+      }
+      // Kept alive if a callback stops watching the query
+      auto query = it->second;
+      query->isRunning = false;
+
+      if (status.type != SQLiteOk) {
+        if (query->onError != nullptr) {
+          rejectWithError(rt, query->onError, status.errorMessage);
+        }
+      } else {
+        if (needsTables) {
+          query->tables = std::move(*tables);
+          query->hasTables = true;
+        }
+        if (!query->hasResult || hash != query->lastHash) {
+          query->hasResult = true;
+          query->lastHash = hash;
+          query->onResult->asObject(rt).asFunction(rt).call(
+              rt, createSequelQueryExecutionResult(rt, status, results.get(),
+                                                   metadata.get()));
+        }
+      }
+
+      if (query->isStale && watchedQueries.count(watchId) > 0) {
+        runWatchedQuery(rt, watchId, query);
+      }
+    });
+  };
+
+  auto result = sqliteExecuteWithLock(
+      query->dbName, ConcurrentLockType::ReadLock, std::move(task),
+      [watchId](std::string const &) {
+        // The database closed, the watch is dropped with it
+        invoker->invokeAsync([watchId] {
+          auto it = watchedQueries.find(watchId);
+          if (it != watchedQueries.end()) {
+            it->second->isRunning = false;
+          }
+        });
+      });
+  if (result.type == SQLiteError) {
+    query->isRunning = false;
+  }
+  return result;
+}
+
+/**
+ * Re-runs the watched queries of the database which read an updated table.
+ * Must be called on the JS thread.
+ */
+void notifyWatchedQueries(jsi::Runtime &rt, std::string const &dbName,
+                          std::vector<TableUpdates> const &updates) {
+  for (auto &entry : watchedQueries) {
+    auto &query = entry.second;
+    // Queries without tables are still running for the first time and pick
+    // up the committed changes
+    if (query->dbName == dbName && query->hasTables &&
+        hasUpdatedTable(query->tables, updates)) {
+      runWatchedQuery(rt, entry.first, query);
+    }
+  }
+}
+
+/**
+ * Callback handler for SQLite transaction updates. Table updates made during a
+ * committed transaction are reported with the COMMIT event.
+ */
+void transactionFinalizerHandler(
+    const TransactionCallbackPayload *payload,
+    std::shared_ptr<std::vector<TableUpdates>> updates) {
   /**
    * No DB operations should occur when this callback is fired from SQLite.
    * This function triggers an async invocation to call watch callbacks,
    * avoiding holding SQLite up.
    */
-  invoker->invokeAsync([payload] {
+  invoker->invokeAsync([payload, updates] {
     try {
       auto global = runtime->global();
       jsi::Function handlerFunction = global.getPropertyAsFunction(
@@ -85,7 +432,41 @@ void transactionFinalizerHandler(const TransactionCallbackPayload *payload) {
 
       auto jsiDbName = jsi::String::createFromAscii(*runtime, *payload->dbName);
       auto jsiEventType = jsi::Value((int)payload->event);
-      handlerFunction.call(*runtime, move(jsiDbName), move(jsiEventType));
+
+      if (updates == nullptr || updates->empty()) {
+        handlerFunction.call(*runtime, move(jsiDbName), move(jsiEventType));
+        return;
+      }
+
+      auto tablePropName = jsi::PropNameID::forAscii(*runtime, "table");
+      auto opTypePropName = jsi::PropNameID::forAscii(*runtime, "opType");
+      auto rowIdsPropName = jsi::PropNameID::forAscii(*runtime, "rowIds");
+
+      auto jsiUpdates = jsi::Array(*runtime, updates->size());
+      for (size_t i = 0; i < updates->size(); i++) {
+        auto &tableUpdates = (*updates)[i];
+        auto jsiTableUpdates = jsi::Object(*runtime);
+        jsiTableUpdates.setProperty(
+            *runtime, tablePropName,
+            jsi::String::createFromUtf8(*runtime, tableUpdates.table));
+        jsiTableUpdates.setProperty(*runtime, opTypePropName,
+                                    jsi::Value(tableUpdates.opType));
+
+        if (!tableUpdates.rowIds.empty()) {
+          auto jsiRowIds = jsi::Array(*runtime, tableUpdates.rowIds.size());
+          for (size_t j = 0; j < tableUpdates.rowIds.size(); j++) {
+            jsiRowIds.setValueAtIndex(
+                *runtime, j, jsi::Value((double)tableUpdates.rowIds[j]));
+          }
+          jsiTableUpdates.setProperty(*runtime, rowIdsPropName,
+                                      move(jsiRowIds));
+        }
+
+        jsiUpdates.setValueAtIndex(*runtime, i, move(jsiTableUpdates));
+      }
+
+      handlerFunction.call(*runtime, move(jsiDbName), move(jsiEventType),
+                           move(jsiUpdates));
     } catch (jsi::JSINativeException e) {
       std::cout << e.what() << std::endl;
     } catch (...) {
@@ -94,6 +475,18 @@ void transactionFinalizerHandler(const TransactionCallbackPayload *payload) {
   });
 }
 
+/**
+ * Callback handler for committed table updates. Called once the changes are
+ * visible to the read connections which run the watched queries.
+ */
+void transactionCommittedHandler(
+    const TransactionCallbackPayload *payload,
+    std::shared_ptr<std::vector<TableUpdates>> updates) {
+  invoker->invokeAsync([dbName = *payload->dbName, updates] {
+    notifyWatchedQueries(*runtime, dbName, *updates);
+  });
+}
+
 /**
  * Callback handler for Concurrent context is available
  */
@@ -142,6 +535,7 @@ void osp::install(jsi::Runtime &rt,
     string dbName = args[0].asString(rt).utf8(rt);
     string tempDocPath = string(docPathStr);
     unsigned int numReadConnections = 0;
+    ConnectionOptions connectionOptions;
 
     if (count > 1 && !args[1].isUndefined() && !args[1].isNull()) {
       if (!args[1].isObject()) {
@@ -156,6 +550,8 @@ void osp::install(jsi::Runtime &rt,
         numReadConnections = numReadConnectionsProperty.asNumber();
       }
 
+      connectionOptions = jsiConnectionOptions(rt, options);
+
       auto locationPropertyProperty = options.getProperty(rt, "location");
       if (!locationPropertyProperty.isUndefined() &&
           !locationPropertyProperty.isNull()) {
@@ -164,9 +560,10 @@ void osp::install(jsi::Runtime &rt,
       }
     }
 
-    auto result = sqliteOpenDb(
-        dbName, tempDocPath, &contextLockAvailableHandler, &updateTableHandler,
-        &transactionFinalizerHandler, numReadConnections);
+    auto result = sqliteOpenDb(dbName, tempDocPath, &contextLockAvailableHandler,
+                               &transactionFinalizerHandler,
+                               &transactionCommittedHandler, numReadConnections,
+                               connectionOptions);
     if (result.type == SQLiteError) {
       throw jsi::JSError(rt, result.errorMessage.c_str());
     }
@@ -244,6 +641,15 @@ void osp::install(jsi::Runtime &rt,
 
     string dbName = args[0].asString(rt).utf8(rt);
 
+    // Queries of a closed database are never updated again
+    for (auto it = watchedQueries.begin(); it != watchedQueries.end();) {
+      if (it->second->dbName == dbName) {
+        it = watchedQueries.erase(it);
+      } else {
+        it++;
+      }
+    }
+
     SQLiteOPResult result = sqliteCloseDb(dbName);
 
     if (result.type == SQLiteError) {
@@ -297,55 +703,302 @@ void osp::install(jsi::Runtime &rt,
     const string contextLockId = args[1].asString(rt).utf8(rt);
     const string query = args[2].asString(rt).utf8(rt);
     const jsi::Value &originalParams = args[3];
+    const QuickQueryOptions options =
+        count > 4 ? jsiQueryOptions(rt, args[4]) : QuickQueryOptions();
 
     // Converting query parameters inside the javascript caller thread
-    vector<QuickValue> params;
-    jsiQueryArgumentsToSequelParam(rt, originalParams, &params);
+    auto params = make_shared<vector<QuickValue>>();
+    jsiQueryArgumentsToSequelParam(rt, originalParams, params.get());
 
     auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
     auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
       auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
       auto reject = std::make_shared<jsi::Value>(rt, args[1]);
 
-      auto task = [&rt, dbName, contextLockId, query,
-                   params = make_shared<vector<QuickValue>>(params), resolve,
-                   reject](sqlite3 *db) {
-        try {
-          vector<map<string, QuickValue>> results;
-          vector<QuickColumnMetadata> metadata;
-          auto status =
-              sqliteExecuteWithDB(db, query, params.get(), &results, &metadata);
-          invoker->invokeAsync(
-              [&rt,
-               results = make_shared<vector<map<string, QuickValue>>>(results),
-               metadata = make_shared<vector<QuickColumnMetadata>>(metadata),
-               status_copy = move(status), resolve, reject] {
-                if (status_copy.type == SQLiteOk) {
-                  auto jsiResult = createSequelQueryExecutionResult(
-                      rt, status_copy, results.get(), metadata.get());
-                  resolve->asObject(rt).asFunction(rt).call(rt,
-                                                            move(jsiResult));
-                } else {
-                  auto errorCtr =
-                      rt.global().getPropertyAsFunction(rt, "Error");
-                  auto error = errorCtr.callAsConstructor(
-                      rt, jsi::String::createFromUtf8(
-                              rt, status_copy.errorMessage));
-                  reject->asObject(rt).asFunction(rt).call(rt, error);
-                }
-              });
-        } catch (std::exception &exc) {
-          invoker->invokeAsync([&rt, &exc] { jsi::JSError(rt, exc.what()); });
+      auto task =
+          createExecuteTask(rt, query, params, options, resolve, reject);
+
+      auto queueResult =
+          sqliteQueueInContext(dbName, contextLockId, std::move(task));
+      if (queueResult.type == SQLiteError) {
+        rejectWithError(rt, reject, queueResult.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+  auto executeWithLock = HOSTFN("executeWithLock", 5) {
+    if (count < 4) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][executeWithLock] "
+                             "Incorrect arguments for executeWithLock");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const ConcurrentLockType lockType = (ConcurrentLockType)args[1].asNumber();
+    const string query = args[2].asString(rt).utf8(rt);
+    const jsi::Value &originalParams = args[3];
+    const QuickQueryOptions options =
+        count > 4 ? jsiQueryOptions(rt, args[4]) : QuickQueryOptions();
+
+    // Converting query parameters inside the javascript caller thread
+    auto params = make_shared<vector<QuickValue>>();
+    jsiQueryArgumentsToSequelParam(rt, originalParams, params.get());
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task =
+          createExecuteTask(rt, query, params, options, resolve, reject);
+
+      auto result = sqliteExecuteWithLock(dbName, lockType, std::move(task),
+                                          createTaskRejection(rt, reject));
+      if (result.type == SQLiteError) {
+        rejectWithError(rt, reject, result.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+  auto executeReads = HOSTFN("executeReads", 2) {
+    if (count < 2 || !args[0].isString() || !args[1].isObject() ||
+        !args[1].asObject(rt).isArray(rt)) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][executeReads] "
+                             "database name and an array of queries are "
+                             "required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const jsi::Array queriesArray = args[1].asObject(rt).asArray(rt);
+
+    // Converting query parameters inside the javascript caller thread
+    vector<QuickQueryArguments> queries;
+    for (size_t i = 0; i < queriesArray.length(rt); i++) {
+      const jsi::Array query =
+          queriesArray.getValueAtIndex(rt, i).asObject(rt).asArray(rt);
+      if (query.length(rt) == 0) {
+        throw jsi::JSError(rt, "[react-native-quick-sqlite][executeReads] "
+                               "each query requires SQL");
+      }
+      auto params = make_shared<vector<QuickValue>>();
+      if (query.length(rt) > 1) {
+        jsiQueryArgumentsToSequelParam(rt, query.getValueAtIndex(rt, 1),
+                                       params.get());
+      }
+      queries.push_back(QuickQueryArguments{
+          query.getValueAtIndex(rt, 0).asString(rt).utf8(rt), params});
+    }
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      if (queries.empty()) {
+        resolve->asObject(rt).asFunction(rt).call(rt, jsi::Array(rt, 0));
+        return {};
+      }
+
+      auto reads = make_shared<ParallelReads>(queries);
+
+      for (size_t i = 0; i < reads->queries.size(); i++) {
+        // Each query gets its own read lock, idle read connections run them
+        // concurrently
+        auto task = [&rt, reads, i, resolve, reject](ConnectionState *state) {
+          auto &query = reads->queries[i];
+          reads->results[i].int64Values = state->int64Results;
+          QueryStats queryStats;
+          reads->statuses[i] = sqliteExecuteWithDB(
+              state->connection, query.sql, query.params.get(),
+              &reads->results[i], &reads->metadata[i], &state->statementCache,
+              state->stats->isEnabled() ? &queryStats : nullptr);
+          state->stats->recordQuery(queryStats);
+
+          if (--reads->remaining > 0) {
+            return;
+          }
+
+          invoker->invokeAsync([&rt, reads, resolve, reject] {
+            for (auto &status : reads->statuses) {
+              if (status.type != SQLiteOk) {
+                rejectWithError(rt, reject, status.errorMessage);
+                return;
+              }
+            }
+
+            auto jsiResults = jsi::Array(rt, reads->queries.size());
+            for (size_t j = 0; j < reads->queries.size(); j++) {
+              jsiResults.setValueAtIndex(
+                  rt, j,
+                  createSequelQueryExecutionResult(rt, reads->statuses[j],
+                                                   &reads->results[j],
+                                                   &reads->metadata[j]));
+            }
+            resolve->asObject(rt).asFunction(rt).call(rt, move(jsiResults));
+          });
+        };
+
+        auto result = sqliteExecuteWithLock(dbName, ReadLock, std::move(task),
+                                            createTaskRejection(rt, reject));
+        if (result.type == SQLiteError) {
+          // Only fails if the DB is not open, no query has been queued
+          rejectWithError(rt, reject, result.errorMessage);
+          return {};
         }
-      };
+      }
 
-      sqliteQueueInContext(dbName, contextLockId, task);
       return {};
     }));
 
     return promise;
   });
 
+  auto openPipeline = HOSTFN("openPipeline", 2) {
+    if (count < 2 || !args[0].isString() || !args[1].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][openPipeline] "
+                             "database name and context ID are required");
+    }
+
+    auto pipeline = make_shared<Pipeline>();
+    pipeline->dbName = args[0].asString(rt).utf8(rt);
+    pipeline->contextId = args[1].asString(rt).utf8(rt);
+    pipeline->savepoint =
+        "quick_sqlite_pipeline_" + std::to_string(nextPipelineId++);
+
+    auto execute = HOSTFN("execute", 2) {
+      if (pipeline->isFinished) {
+        throw jsi::JSError(rt, "[react-native-quick-sqlite][pipeline] "
+                               "Cannot execute after the pipeline finished");
+      }
+      if (count < 1 || !args[0].isString()) {
+        throw jsi::JSError(rt, "[react-native-quick-sqlite][pipeline] SQL "
+                               "is required");
+      }
+
+      const string query = args[0].asString(rt).utf8(rt);
+      auto params = make_shared<vector<QuickValue>>();
+      if (count > 1) {
+        jsiQueryArgumentsToSequelParam(rt, args[1], params.get());
+      }
+      auto statement = make_shared<PipelineStatement>();
+      pipeline->statements.push_back(statement);
+      size_t index = pipeline->statements.size() - 1;
+
+      // Queued right away, the worker runs it while JS queues the next one
+      auto task = [pipeline, statement, query, params,
+                   index](ConnectionState *state) {
+        if (pipeline->isFailed) {
+          return;
+        }
+        sqlite3 *db = state->connection;
+        if (!pipeline->isStarted) {
+          pipeline->isStarted = true;
+          auto savepoint = sqliteExecuteLiteralWithDB(
+              db, "SAVEPOINT " + pipeline->savepoint);
+          if (savepoint.type == SQLiteError) {
+            pipeline->isStarted = false;
+            pipeline->isFailed = true;
+            pipeline->errorMessage = savepoint.message;
+            return;
+          }
+        }
+
+        statement->results.int64Values = state->int64Results;
+        QueryStats queryStats;
+        statement->status = sqliteExecuteWithDB(
+            db, query, params.get(), &statement->results, &statement->metadata,
+            &state->statementCache,
+            state->stats->isEnabled() ? &queryStats : nullptr);
+        state->stats->recordQuery(queryStats);
+
+        if (statement->status.type == SQLiteError) {
+          pipeline->isFailed = true;
+          pipeline->errorMessage = statement->status.errorMessage +
+                                   " (pipeline statement " +
+                                   std::to_string(index) + ")";
+        }
+      };
+
+      auto queueResult = sqliteQueueInContext(
+          pipeline->dbName, pipeline->contextId, std::move(task));
+      if (queueResult.type == SQLiteError) {
+        throw jsi::JSError(rt, queueResult.errorMessage);
+      }
+      return {};
+    });
+
+    auto finish = HOSTFN("finish", 1) {
+      if (pipeline->isFinished) {
+        throw jsi::JSError(rt, "[react-native-quick-sqlite][pipeline] The "
+                               "pipeline already finished");
+      }
+      pipeline->isFinished = true;
+      // Aborted pipelines are rolled back, e.g. if queueing statements failed
+      const bool abort = count > 0 && args[0].isBool() && args[0].getBool();
+
+      auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+      auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+        auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+        auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+        auto task = [&rt, pipeline, abort, resolve,
+                     reject](ConnectionState *state) {
+          sqlite3 *db = state->connection;
+          if (pipeline->isStarted) {
+            if (pipeline->isFailed || abort) {
+              sqliteExecuteLiteralWithDB(db, "ROLLBACK TO " +
+                                                 pipeline->savepoint);
+            }
+            sqliteExecuteLiteralWithDB(db, "RELEASE " + pipeline->savepoint);
+          }
+
+          invoker->invokeAsync([&rt, pipeline, abort, resolve, reject] {
+            if (pipeline->isFailed) {
+              rejectWithError(rt, reject, pipeline->errorMessage);
+              return;
+            }
+            if (abort) {
+              rejectWithError(rt, reject,
+                              "[react-native-quick-sqlite][pipeline] The "
+                              "pipeline was aborted");
+              return;
+            }
+
+            auto &statements = pipeline->statements;
+            auto jsiResults = jsi::Array(rt, statements.size());
+            for (size_t i = 0; i < statements.size(); i++) {
+              jsiResults.setValueAtIndex(
+                  rt, i,
+                  createSequelQueryExecutionResult(rt, statements[i]->status,
+                                                   &statements[i]->results,
+                                                   &statements[i]->metadata));
+            }
+            resolve->asObject(rt).asFunction(rt).call(rt, move(jsiResults));
+          });
+        };
+
+        auto queueResult = sqliteQueueInContext(
+            pipeline->dbName, pipeline->contextId, std::move(task));
+        if (queueResult.type == SQLiteError) {
+          rejectWithError(rt, reject, queueResult.errorMessage);
+        }
+        return {};
+      }));
+
+      return promise;
+    });
+
+    auto res = jsi::Object(rt);
+    res.setProperty(rt, "execute", move(execute));
+    res.setProperty(rt, "finish", move(finish));
+    return res;
+  });
+
   auto executeBatch = HOSTFN("executeBatch", 2) {
     if (sizeof(args) < 3) {
       throw jsi::JSError(rt, "[react-native-quick-sqlite][executeAsyncBatch] "
@@ -366,39 +1019,111 @@ void osp::install(jsi::Runtime &rt,
     const jsi::Array &batchParams = params.asObject(rt).asArray(rt);
     const string contextLockId = args[2].asString(rt).utf8(rt);
 
-    vector<QuickQueryArguments> commands;
-    jsiBatchParametersToQuickArguments(rt, batchParams, &commands);
+    auto commands = make_shared<vector<QuickBatchCommand>>();
+    jsiBatchParametersToQuickArguments(rt, batchParams, commands.get());
 
     auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
     auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
       auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
       auto reject = std::make_shared<jsi::Value>(rt, args[1]);
 
-      auto task = [&rt, dbName,
-                   commands =
-                       make_shared<vector<QuickQueryArguments>>(commands),
-                   resolve, reject, contextLockId](sqlite3 *db) {
+      auto task = [&rt, dbName, commands, resolve, reject,
+                   contextLockId](ConnectionState *state) {
         try {
           // Inside the new worker thread, we can now call sqlite operations
-          auto batchResult = sqliteExecuteBatch(db, commands.get());
+          auto batchResult = sqliteExecuteBatch(
+              state->connection, commands.get(), &state->statementCache);
           invoker->invokeAsync(
               [&rt, batchResult = move(batchResult), resolve, reject] {
                 if (batchResult.type == SQLiteOk) {
                   auto res = jsi::Object(rt);
                   res.setProperty(rt, "rowsAffected",
                                   jsi::Value(batchResult.affectedRows));
+
+                  auto groups = jsi::Array(rt, batchResult.groups.size());
+                  for (size_t i = 0; i < batchResult.groups.size(); i++) {
+                    auto &groupResult = batchResult.groups[i];
+                    auto group = jsi::Object(rt);
+                    group.setProperty(rt, "commands",
+                                      jsi::Value(groupResult.commands));
+                    group.setProperty(rt, "rowsAffected",
+                                      jsi::Value(groupResult.affectedRows));
+                    group.setProperty(rt, "durationMs",
+                                      jsi::Value(groupResult.durationMs));
+                    groups.setValueAtIndex(rt, i, move(group));
+                  }
+                  res.setProperty(rt, "groups", move(groups));
+
                   resolve->asObject(rt).asFunction(rt).call(rt, move(res));
                 } else {
-                  throw jsi::JSError(rt, batchResult.message);
+                  rejectWithError(rt, reject, batchResult.message);
                 }
               });
         } catch (std::exception &exc) {
+          std::string message = exc.what();
           invoker->invokeAsync(
-              [&rt, reject, &exc] { throw jsi::JSError(rt, exc.what()); });
+              [&rt, reject, message] { rejectWithError(rt, reject, message); });
         }
       };
 
-      sqliteQueueInContext(dbName, contextLockId, task);
+      auto queueResult =
+          sqliteQueueInContext(dbName, contextLockId, std::move(task));
+      if (queueResult.type == SQLiteError) {
+        rejectWithError(rt, reject, queueResult.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+  // Executes a statement for each packed row
+  auto executePacked = HOSTFN("executePacked", 4) {
+    if (count < 4 || !args[0].isString() || !args[1].isString() ||
+        !args[2].isObject() || !args[2].asObject(rt).isArrayBuffer(rt) ||
+        !args[3].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][executePacked] "
+                             "database name, SQL, an ArrayBuffer of packed "
+                             "rows and a context ID are required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const string query = args[1].asString(rt).utf8(rt);
+    const string contextLockId = args[3].asString(rt).utf8(rt);
+    // The single copy made on the JS thread, the rows are decoded by the
+    // worker
+    auto buffer = args[2].asObject(rt).getArrayBuffer(rt);
+    auto rows = make_shared<vector<uint8_t>>(buffer.data(rt),
+                                             buffer.data(rt) + buffer.size(rt));
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task = [&rt, query, rows, resolve, reject](ConnectionState *state) {
+        auto packedResult =
+            sqliteExecutePacked(state->connection, query, rows->data(),
+                                rows->size(), &state->statementCache);
+        invoker->invokeAsync(
+            [&rt, result = move(packedResult), resolve, reject] {
+              if (result.type == SQLiteOk) {
+                auto res = jsi::Object(rt);
+                res.setProperty(rt, "rowsAffected",
+                                jsi::Value(result.affectedRows));
+                res.setProperty(rt, "commands", jsi::Value(result.commands));
+                resolve->asObject(rt).asFunction(rt).call(rt, move(res));
+              } else {
+                rejectWithError(rt, reject, result.message);
+              }
+            });
+      };
+
+      auto queueResult =
+          sqliteQueueInContext(dbName, contextLockId, std::move(task));
+      if (queueResult.type == SQLiteError) {
+        rejectWithError(rt, reject, queueResult.errorMessage);
+      }
       return {};
     }));
 
@@ -406,8 +1131,8 @@ void osp::install(jsi::Runtime &rt,
   });
 
   // Load SQL File from disk in another thread
-  auto loadFileAsync = HOSTFN("loadFile", 2) {
-    if (sizeof(args) < 3) {
+  auto loadFileAsync = HOSTFN("loadFile", 4) {
+    if (count < 3) {
       throw jsi::JSError(rt, "[react-native-quick-sqlite][loadFileAsync] "
                              "Incorrect parameter count");
       return {};
@@ -416,15 +1141,39 @@ void osp::install(jsi::Runtime &rt,
     const string dbName = args[0].asString(rt).utf8(rt);
     const string sqlFileName = args[1].asString(rt).utf8(rt);
     const string contextLockId = args[2].asString(rt).utf8(rt);
+    // Optional callback for progress events
+    shared_ptr<jsi::Value> onProgress =
+        count > 3 && args[3].isObject() && args[3].asObject(rt).isFunction(rt)
+            ? make_shared<jsi::Value>(rt, args[3])
+            : nullptr;
 
     auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
     auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
       auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
       auto reject = std::make_shared<jsi::Value>(rt, args[1]);
 
-      auto task = [&rt, dbName, sqlFileName, resolve, reject](sqlite3 *db) {
+      auto task = [&rt, dbName, sqlFileName, onProgress, resolve,
+                   reject](ConnectionState *state) {
         try {
-          const auto importResult = sqliteImportFile(db, sqlFileName);
+          SQLImportProgressCallback progressCallback = nullptr;
+          if (onProgress != nullptr) {
+            progressCallback = [&rt,
+                                onProgress](SQLImportProgress const &progress) {
+              invoker->invokeAsync([&rt, onProgress, progress] {
+                auto event = jsi::Object(rt);
+                event.setProperty(rt, "bytesRead",
+                                  jsi::Value((double)progress.bytesRead));
+                event.setProperty(rt, "totalBytes",
+                                  jsi::Value((double)progress.totalBytes));
+                event.setProperty(rt, "commands",
+                                  jsi::Value(progress.commands));
+                onProgress->asObject(rt).asFunction(rt).call(rt, move(event));
+              });
+            };
+          }
+
+          const auto importResult = sqliteImportFile(
+              state->connection, sqlFileName, progressCallback);
 
           invoker->invokeAsync(
               [&rt, result = move(importResult), resolve, reject] {
@@ -435,16 +1184,252 @@ void osp::install(jsi::Runtime &rt,
                   res.setProperty(rt, "commands", jsi::Value(result.commands));
                   resolve->asObject(rt).asFunction(rt).call(rt, move(res));
                 } else {
-                  throw jsi::JSError(rt, result.message);
+                  rejectWithError(rt, reject, result.message);
                 }
               });
         } catch (std::exception &exc) {
-          //          LOGW("Catched exception: %s", exc.what());
+          std::string message = exc.what();
           invoker->invokeAsync(
-              [&rt, err = exc.what(), reject] { throw jsi::JSError(rt, err); });
+              [&rt, message, reject] { rejectWithError(rt, reject, message); });
         }
       };
-      sqliteQueueInContext(dbName, contextLockId, task);
+
+      auto queueResult =
+          sqliteQueueInContext(dbName, contextLockId, std::move(task));
+      if (queueResult.type == SQLiteError) {
+        rejectWithError(rt, reject, queueResult.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+  // Copies the database with the online backup API on a read connection
+  auto backup = HOSTFN("backup", 5) {
+    if (count < 2 || !args[0].isString() || !args[1].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][backup] database "
+                             "name and destination name are required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    string destinationDocPath = string(docPathStr);
+    if (count > 2 && !args[2].isUndefined() && !args[2].isNull()) {
+      if (!args[2].isString()) {
+        throw jsi::JSError(rt, "[react-native-quick-sqlite][backup] "
+                               "destination location must be a string");
+      }
+      destinationDocPath =
+          destinationDocPath + "/" + args[2].asString(rt).utf8(rt);
+    }
+    const string destinationPath =
+        get_db_path(args[1].asString(rt).utf8(rt), destinationDocPath);
+    const int pagesPerStep = count > 3 && args[3].isNumber()
+                                 ? (int)args[3].asNumber()
+                                 : DEFAULT_BACKUP_PAGES_PER_STEP;
+    // Optional callback for progress events
+    shared_ptr<jsi::Value> onProgress =
+        count > 4 && args[4].isObject() && args[4].asObject(rt).isFunction(rt)
+            ? make_shared<jsi::Value>(rt, args[4])
+            : nullptr;
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task = [&rt, destinationPath, pagesPerStep, onProgress, resolve,
+                   reject](ConnectionState *state) {
+        SQLBackupProgressCallback progressCallback = nullptr;
+        if (onProgress != nullptr) {
+          progressCallback = [&rt,
+                              onProgress](SQLBackupProgress const &progress) {
+            invoker->invokeAsync([&rt, onProgress, progress] {
+              auto event = jsi::Object(rt);
+              event.setProperty(rt, "remainingPages",
+                                jsi::Value(progress.remainingPages));
+              event.setProperty(rt, "totalPages",
+                                jsi::Value(progress.totalPages));
+              onProgress->asObject(rt).asFunction(rt).call(rt, move(event));
+            });
+          };
+        }
+
+        auto backupResult = sqliteBackupWithDB(
+            state->connection, destinationPath, pagesPerStep, progressCallback);
+
+        invoker->invokeAsync(
+            [&rt, result = move(backupResult), resolve, reject] {
+              if (result.type == SQLiteOk) {
+                auto res = jsi::Object(rt);
+                res.setProperty(rt, "totalPages",
+                                jsi::Value(result.totalPages));
+                resolve->asObject(rt).asFunction(rt).call(rt, move(res));
+              } else {
+                rejectWithError(rt, reject, result.message);
+              }
+            });
+      };
+
+      auto result = sqliteExecuteWithLock(
+          dbName, ConcurrentLockType::ReadLock, std::move(task),
+          createTaskRejection(rt, reject));
+      if (result.type == SQLiteError) {
+        rejectWithError(rt, reject, result.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+  auto openCursor = HOSTFN("openCursor", 4) {
+    if (count < 4) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][openCursor] "
+                             "Incorrect arguments for openCursor");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const string contextLockId = args[1].asString(rt).utf8(rt);
+    const string query = args[2].asString(rt).utf8(rt);
+
+    auto params = make_shared<vector<QuickValue>>();
+    jsiQueryArgumentsToSequelParam(rt, args[3], params.get());
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task = [&rt, query, params, resolve,
+                   reject](ConnectionState *state) {
+        sqlite3_stmt *statement;
+        int status = state->statementCache.acquire(query, &statement);
+        if (status != SQLITE_OK || statement == nullptr) {
+          string message =
+              "[react-native-quick-sqlite] SQL execution error: " +
+              string(status != SQLITE_OK ? sqlite3_errmsg(state->connection)
+                                         : "No SQL statement provided");
+          invoker->invokeAsync([&rt, message, reject] {
+            rejectWithError(rt, reject, message);
+          });
+          return;
+        }
+
+        bindStatement(statement, params.get());
+        // The statement is only stepped once rows are fetched, the cursor
+        // keeps the bound values alive until then
+        unsigned int cursorId = state->openCursor(statement, params);
+        invoker->invokeAsync([&rt, cursorId, resolve] {
+          resolve->asObject(rt).asFunction(rt).call(
+              rt, jsi::Value((double)cursorId));
+        });
+      };
+
+      auto queueResult =
+          sqliteQueueInContext(dbName, contextLockId, std::move(task));
+      if (queueResult.type == SQLiteError) {
+        rejectWithError(rt, reject, queueResult.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+  auto fetchCursor = HOSTFN("fetchCursor", 4) {
+    if (count < 4) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][fetchCursor] "
+                             "Incorrect arguments for fetchCursor");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const string contextLockId = args[1].asString(rt).utf8(rt);
+    const unsigned int cursorId = args[2].asNumber();
+    const size_t chunkSize = args[3].asNumber();
+
+    if (chunkSize == 0) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][fetchCursor] "
+                             "The chunk size must be greater than zero");
+    }
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task = [&rt, cursorId, chunkSize, resolve,
+                   reject](ConnectionState *state) {
+        sqlite3_stmt *statement = state->getCursor(cursorId);
+        if (statement == nullptr) {
+          invoker->invokeAsync([&rt, reject] {
+            rejectWithError(rt, reject,
+                            "[react-native-quick-sqlite] Cursor is not open");
+          });
+          return;
+        }
+
+        auto results = make_shared<QuickQueryResult>();
+        results->int64Values = state->int64Results;
+        readStatementColumnNames(statement, results.get());
+        bool isDone;
+        auto status = sqliteStepStatement(state->connection, statement,
+                                          results.get(), chunkSize, &isDone);
+        if (isDone || status.type == SQLiteError) {
+          // Release the statement as soon as possible
+          state->closeCursor(cursorId);
+        }
+
+        invoker->invokeAsync([&rt, results, isDone, status = move(status),
+                              resolve, reject] {
+          if (status.type == SQLiteOk) {
+            auto jsiResult = createSequelQueryExecutionResult(
+                rt, status, results.get(), NULL);
+            jsiResult.asObject(rt).setProperty(rt, "done", jsi::Value(isDone));
+            resolve->asObject(rt).asFunction(rt).call(rt, move(jsiResult));
+          } else {
+            rejectWithError(rt, reject, status.errorMessage);
+          }
+        });
+      };
+
+      auto queueResult =
+          sqliteQueueInContext(dbName, contextLockId, std::move(task));
+      if (queueResult.type == SQLiteError) {
+        rejectWithError(rt, reject, queueResult.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+  auto closeCursor = HOSTFN("closeCursor", 3) {
+    if (count < 3) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][closeCursor] "
+                             "Incorrect arguments for closeCursor");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const string contextLockId = args[1].asString(rt).utf8(rt);
+    const unsigned int cursorId = args[2].asNumber();
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task = [&rt, cursorId, resolve](ConnectionState *state) {
+        state->closeCursor(cursorId);
+        invoker->invokeAsync(
+            [&rt, resolve] { resolve->asObject(rt).asFunction(rt).call(rt); });
+      };
+
+      auto queueResult =
+          sqliteQueueInContext(dbName, contextLockId, std::move(task));
+      if (queueResult.type == SQLiteError) {
+        rejectWithError(rt, reject, queueResult.errorMessage);
+      }
       return {};
     }));
 
@@ -468,7 +1453,7 @@ void osp::install(jsi::Runtime &rt,
     ConcurrentLockType lockType = (ConcurrentLockType)args[2].asNumber();
 
     auto lockResult = sqliteRequestLock(dbName, lockId, lockType);
-    vector<map<string, QuickValue>> resultsHolder;
+    QuickQueryResult resultsHolder;
     auto jsiResult =
         createSequelQueryExecutionResult(rt, lockResult, &resultsHolder, NULL);
     return jsiResult;
@@ -493,19 +1478,512 @@ void osp::install(jsi::Runtime &rt,
     return {};
   });
 
+  auto setStatsEnabled = HOSTFN("setStatsEnabled", 3) {
+    if (count < 2 || !args[0].isString() || !args[1].isBool()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][setStatsEnabled] "
+                             "database name and enabled flag are required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const bool enabled = args[1].getBool();
+    bool profileStatements = false;
+    if (count > 2 && args[2].isObject()) {
+      auto profileProperty =
+          args[2].asObject(rt).getProperty(rt, "profileStatements");
+      profileStatements = profileProperty.isBool() && profileProperty.getBool();
+    }
+
+    auto result = sqliteSetStatsEnabled(dbName, enabled, profileStatements);
+    if (result.type == SQLiteError) {
+      throw jsi::JSError(rt, result.errorMessage.c_str());
+    }
+    return {};
+  });
+
+  auto getStats = HOSTFN("getStats", 2) {
+    if (count < 1 || !args[0].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][getStats] "
+                             "database name is required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const bool reset = count > 1 && args[1].isBool() && args[1].getBool();
+
+    vector<ConnectionStatsSnapshot> stats;
+    auto result = sqliteGetStats(dbName, reset, &stats);
+    if (result.type == SQLiteError) {
+      throw jsi::JSError(rt, result.errorMessage.c_str());
+    }
+
+    auto toJSI = [&rt](ConnectionStatsSnapshot const &snapshot) {
+      auto res = jsi::Object(rt);
+      res.setProperty(rt, "tasks", jsi::Value((double)snapshot.tasks));
+      res.setProperty(rt, "queueWaitMs", jsi::Value(snapshot.queueWaitMs));
+      res.setProperty(rt, "maxQueueWaitMs",
+                      jsi::Value(snapshot.maxQueueWaitMs));
+      res.setProperty(rt, "queries", jsi::Value((double)snapshot.queries));
+      res.setProperty(rt, "prepareMs", jsi::Value(snapshot.prepareMs));
+      res.setProperty(rt, "stepMs", jsi::Value(snapshot.stepMs));
+      res.setProperty(rt, "marshallingMs", jsi::Value(snapshot.marshallingMs));
+      res.setProperty(rt, "rows", jsi::Value((double)snapshot.rows));
+      res.setProperty(rt, "fullscanSteps",
+                      jsi::Value((double)snapshot.fullscanSteps));
+      res.setProperty(rt, "sorts", jsi::Value((double)snapshot.sorts));
+      res.setProperty(rt, "vmSteps", jsi::Value((double)snapshot.vmSteps));
+      res.setProperty(rt, "statementCacheHits",
+                      jsi::Value((double)snapshot.statementCacheHits));
+      res.setProperty(rt, "statementCacheMisses",
+                      jsi::Value((double)snapshot.statementCacheMisses));
+
+      auto statements = jsi::Array(rt, snapshot.statements.size());
+      for (size_t i = 0; i < snapshot.statements.size(); i++) {
+        auto &profile = snapshot.statements[i];
+        auto statement = jsi::Object(rt);
+        statement.setProperty(rt, "sql",
+                              jsi::String::createFromUtf8(rt, profile.sql));
+        statement.setProperty(rt, "count", jsi::Value((double)profile.count));
+        statement.setProperty(rt, "totalMs", jsi::Value(profile.totalMs));
+        statement.setProperty(rt, "maxMs", jsi::Value(profile.maxMs));
+        statements.setValueAtIndex(rt, i, move(statement));
+      }
+      res.setProperty(rt, "statements", move(statements));
+      return res;
+    };
+
+    auto res = jsi::Object(rt);
+    res.setProperty(rt, "write", toJSI(stats[0]));
+    auto reads = jsi::Array(rt, stats.size() - 1);
+    for (size_t i = 1; i < stats.size(); i++) {
+      reads.setValueAtIndex(rt, i - 1, toJSI(stats[i]));
+    }
+    res.setProperty(rt, "read", move(reads));
+    return res;
+  });
+
+  auto requestCheckpoint = HOSTFN("requestCheckpoint", 2) {
+    if (count < 1 || !args[0].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][requestCheckpoint] "
+                             "database name is required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const bool truncate = count > 1 && args[1].isBool() && args[1].getBool();
+
+    auto result = sqliteRequestCheckpoint(dbName, truncate);
+    if (result.type == SQLiteError) {
+      throw jsi::JSError(rt, result.errorMessage.c_str());
+    }
+    return {};
+  });
+
+  auto getCheckpointStats = HOSTFN("getCheckpointStats", 1) {
+    if (count < 1 || !args[0].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][getCheckpointStats] "
+                             "database name is required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    CheckpointStatsSnapshot stats;
+    auto result = sqliteGetCheckpointStats(dbName, &stats);
+    if (result.type == SQLiteError) {
+      throw jsi::JSError(rt, result.errorMessage.c_str());
+    }
+
+    auto res = jsi::Object(rt);
+    res.setProperty(rt, "checkpoints", jsi::Value((double)stats.checkpoints));
+    res.setProperty(rt, "passiveCheckpoints",
+                    jsi::Value((double)stats.passiveCheckpoints));
+    res.setProperty(rt, "truncateCheckpoints",
+                    jsi::Value((double)stats.truncateCheckpoints));
+    res.setProperty(rt, "busyCheckpoints",
+                    jsi::Value((double)stats.busyCheckpoints));
+    res.setProperty(rt, "framesCheckpointed",
+                    jsi::Value((double)stats.framesCheckpointed));
+    res.setProperty(rt, "walFrames", jsi::Value(stats.walFrames));
+    res.setProperty(rt, "totalMs", jsi::Value(stats.totalMs));
+    res.setProperty(rt, "maxMs", jsi::Value(stats.maxMs));
+    return res;
+  });
+
+  auto releaseMemory = HOSTFN("releaseMemory", 1) {
+    if (count < 1 || !args[0].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][releaseMemory] "
+                             "database name is required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    auto result = sqliteReleaseMemory(dbName);
+    if (result.type == SQLiteError) {
+      throw jsi::JSError(rt, result.errorMessage.c_str());
+    }
+    return {};
+  });
+
+  auto interrupt = HOSTFN("interrupt", 2) {
+    if (count < 1 || !args[0].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][interrupt] "
+                             "database name is required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    // Interrupts all connections without a context
+    const string contextLockId =
+        count > 1 && args[1].isString() ? args[1].asString(rt).utf8(rt) : "";
+    auto result = sqliteInterrupt(dbName, contextLockId);
+    if (result.type == SQLiteError) {
+      throw jsi::JSError(rt, result.errorMessage.c_str());
+    }
+    return {};
+  });
+
+  auto search = HOSTFN("search", 4) {
+    if (count < 3 || !args[0].isString() || !args[1].isString() ||
+        !args[2].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][search] database "
+                             "name, table and query are required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    SearchOptions searchOptions;
+    searchOptions.table = args[1].asString(rt).utf8(rt);
+    searchOptions.match = args[2].asString(rt).utf8(rt);
+    if (count > 3 && args[3].isObject()) {
+      auto options = args[3].asObject(rt);
+      auto limit = options.getProperty(rt, "limit");
+      if (limit.isNumber()) {
+        searchOptions.limit = (int)limit.asNumber();
+      }
+      auto columns = options.getProperty(rt, "columns");
+      if (columns.isObject() && columns.asObject(rt).isArray(rt)) {
+        auto array = columns.asObject(rt).asArray(rt);
+        for (size_t i = 0; i < array.size(rt); i++) {
+          searchOptions.columns.push_back(
+              array.getValueAtIndex(rt, i).asString(rt).utf8(rt));
+        }
+      }
+      auto weights = options.getProperty(rt, "weights");
+      if (weights.isObject() && weights.asObject(rt).isArray(rt)) {
+        auto array = weights.asObject(rt).asArray(rt);
+        for (size_t i = 0; i < array.size(rt); i++) {
+          searchOptions.weights.push_back(
+              array.getValueAtIndex(rt, i).asNumber());
+        }
+      }
+      auto snippet = options.getProperty(rt, "snippet");
+      if (snippet.isObject()) {
+        auto snippetOptions = snippet.asObject(rt);
+        searchOptions.includeSnippet = true;
+        auto column = snippetOptions.getProperty(rt, "column");
+        if (column.isNumber()) {
+          searchOptions.snippet.column = (int)column.asNumber();
+        }
+        auto start = snippetOptions.getProperty(rt, "start");
+        if (start.isString()) {
+          searchOptions.snippet.start = start.asString(rt).utf8(rt);
+        }
+        auto end = snippetOptions.getProperty(rt, "end");
+        if (end.isString()) {
+          searchOptions.snippet.end = end.asString(rt).utf8(rt);
+        }
+        auto ellipsis = snippetOptions.getProperty(rt, "ellipsis");
+        if (ellipsis.isString()) {
+          searchOptions.snippet.ellipsis = ellipsis.asString(rt).utf8(rt);
+        }
+        auto tokens = snippetOptions.getProperty(rt, "tokens");
+        if (tokens.isNumber()) {
+          searchOptions.snippet.tokens = (int)tokens.asNumber();
+        }
+      }
+    }
+
+    auto params = make_shared<vector<QuickValue>>();
+    const string query = buildSearchQuery(searchOptions, params.get());
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      // Only the ranked top results are converted to JS values
+      auto task = createExecuteTask(rt, query, params, QuickQueryOptions(),
+                                    resolve, reject);
+
+      auto result = sqliteExecuteWithLock(
+          dbName, ConcurrentLockType::ReadLock, std::move(task),
+          createTaskRejection(rt, reject));
+      if (result.type == SQLiteError) {
+        rejectWithError(rt, reject, result.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+#ifdef QUICK_SQLITE_HAS_SESSION
+  auto createSession = HOSTFN("createSession", 2) {
+    if (count < 1 || !args[0].isString()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][createSession] "
+                             "database name is required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    vector<string> tables;
+    if (count > 1 && args[1].isObject() && args[1].asObject(rt).isArray(rt)) {
+      auto tableNames = args[1].asObject(rt).asArray(rt);
+      for (size_t i = 0; i < tableNames.size(rt); i++) {
+        tables.push_back(
+            tableNames.getValueAtIndex(rt, i).asString(rt).utf8(rt));
+      }
+    }
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task = [&rt, tables, resolve, reject](ConnectionState *state) {
+        sqlite3_session *session = nullptr;
+        auto status = sqliteCreateSession(state->connection, tables, &session);
+        const unsigned int sessionId =
+            status.type == SQLiteOk ? state->openSession(session) : 0;
+
+        invoker->invokeAsync([&rt, status, sessionId, resolve, reject] {
+          if (status.type == SQLiteOk) {
+            resolve->asObject(rt).asFunction(rt).call(
+                rt, jsi::Value((double)sessionId));
+          } else {
+            rejectWithError(rt, reject, status.errorMessage);
+          }
+        });
+      };
+
+      // Sessions record the changes made on the write connection
+      auto result = sqliteExecuteWithLock(
+          dbName, ConcurrentLockType::WriteLock, std::move(task),
+          createTaskRejection(rt, reject));
+      if (result.type == SQLiteError) {
+        rejectWithError(rt, reject, result.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+  auto sessionChangeset = HOSTFN("sessionChangeset", 3) {
+    if (count < 2 || !args[0].isString() || !args[1].isNumber()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][sessionChangeset] "
+                             "database name and session id are required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const unsigned int sessionId = (unsigned int)args[1].asNumber();
+    const bool patchset = count > 2 && args[2].isBool() && args[2].getBool();
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task = [&rt, sessionId, patchset, resolve,
+                   reject](ConnectionState *state) {
+        auto changeset = make_shared<vector<uint8_t>>();
+        SQLiteOPResult status;
+        sqlite3_session *session = state->getSession(sessionId);
+        if (session == nullptr) {
+          status = SQLiteOPResult{
+              .type = SQLiteError,
+              .errorMessage = "[react-native-quick-sqlite] Session " +
+                              to_string(sessionId) + " is not open",
+          };
+        } else {
+          status = sqliteSessionChangeset(session, patchset, changeset.get());
+        }
+
+        invoker->invokeAsync([&rt, status, changeset, resolve, reject] {
+          if (status.type == SQLiteOk) {
+            auto buffer = make_shared<QuickArrayBuffer>(move(*changeset));
+            resolve->asObject(rt).asFunction(rt).call(
+                rt, createJSIArrayBuffer(rt, buffer));
+          } else {
+            rejectWithError(rt, reject, status.errorMessage);
+          }
+        });
+      };
+
+      auto result = sqliteExecuteWithLock(
+          dbName, ConcurrentLockType::WriteLock, std::move(task),
+          createTaskRejection(rt, reject));
+      if (result.type == SQLiteError) {
+        rejectWithError(rt, reject, result.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+
+  auto closeSession = HOSTFN("closeSession", 2) {
+    if (count < 2 || !args[0].isString() || !args[1].isNumber()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][closeSession] "
+                             "database name and session id are required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const unsigned int sessionId = (unsigned int)args[1].asNumber();
+
+    auto result = sqliteExecuteWithLock(
+        dbName, ConcurrentLockType::WriteLock,
+        [sessionId](ConnectionState *state) {
+          state->closeSession(sessionId);
+        });
+    if (result.type == SQLiteError) {
+      throw jsi::JSError(rt, result.errorMessage.c_str());
+    }
+    return {};
+  });
+
+  auto applyChangeset = HOSTFN("applyChangeset", 3) {
+    if (count < 2 || !args[0].isString() || !args[1].isObject() ||
+        !args[1].asObject(rt).isArrayBuffer(rt)) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][applyChangeset] "
+                             "database name and an ArrayBuffer changeset are "
+                             "required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    auto buffer = args[1].asObject(rt).getArrayBuffer(rt);
+    // The buffer can't be accessed outside of the JS thread
+    auto changeset = make_shared<vector<uint8_t>>(
+        buffer.data(rt), buffer.data(rt) + buffer.size(rt));
+    const ChangesetConflictAction onConflict =
+        count > 2 && args[2].isNumber()
+            ? (ChangesetConflictAction)args[2].asNumber()
+            : CHANGESET_ABORT;
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task = [&rt, changeset, onConflict, resolve,
+                   reject](ConnectionState *state) {
+        auto status =
+            sqliteApplyChangeset(state->connection, *changeset, onConflict);
+
+        invoker->invokeAsync([&rt, status, resolve, reject] {
+          if (status.type == SQLiteOk) {
+            resolve->asObject(rt).asFunction(rt).call(rt, jsi::Value());
+          } else {
+            rejectWithError(rt, reject, status.errorMessage);
+          }
+        });
+      };
+
+      auto result = sqliteExecuteWithLock(
+          dbName, ConcurrentLockType::WriteLock, std::move(task),
+          createTaskRejection(rt, reject));
+      if (result.type == SQLiteError) {
+        rejectWithError(rt, reject, result.errorMessage);
+      }
+      return {};
+    }));
+
+    return promise;
+  });
+#endif
+
+  auto watch = HOSTFN("watch", 5) {
+    if (count < 4 || !args[0].isString() || !args[1].isString() ||
+        !args[3].isObject() || !args[3].asObject(rt).isFunction(rt)) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][watch] database "
+                             "name, query and result callback are required");
+    }
+
+    auto query = make_shared<WatchedQuery>();
+    query->dbName = args[0].asString(rt).utf8(rt);
+    query->sql = args[1].asString(rt).utf8(rt);
+    query->params = make_shared<vector<QuickValue>>();
+    jsiQueryArgumentsToSequelParam(rt, args[2], query->params.get());
+    query->onResult = make_shared<jsi::Value>(rt, args[3]);
+    if (count > 4 && args[4].isObject() &&
+        args[4].asObject(rt).isFunction(rt)) {
+      query->onError = make_shared<jsi::Value>(rt, args[4]);
+    }
+
+    const unsigned int watchId = nextWatchId++;
+    watchedQueries[watchId] = query;
+    auto result = runWatchedQuery(rt, watchId, query);
+    if (result.type == SQLiteError) {
+      watchedQueries.erase(watchId);
+      throw jsi::JSError(rt, result.errorMessage.c_str());
+    }
+    return jsi::Value((double)watchId);
+  });
+
+  auto unwatch = HOSTFN("unwatch", 1) {
+    if (count < 1 || !args[0].isNumber()) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][unwatch] watch id "
+                             "is required");
+    }
+
+    auto it = watchedQueries.find((unsigned int)args[0].asNumber());
+    if (it != watchedQueries.end()) {
+      // Results of a run in progress are dropped
+      watchedQueries.erase(it);
+    }
+    return {};
+  });
+
   jsi::Object module = jsi::Object(rt);
 
   module.setProperty(rt, "open", move(open));
   module.setProperty(rt, "requestLock", move(requestLock));
   module.setProperty(rt, "releaseLock", move(releaseLock));
   module.setProperty(rt, "executeInContext", move(executeInContext));
+  module.setProperty(rt, "executeWithLock", move(executeWithLock));
+  module.setProperty(rt, "executeReads", move(executeReads));
+  module.setProperty(rt, "openCursor", move(openCursor));
+  module.setProperty(rt, "fetchCursor", move(fetchCursor));
+  module.setProperty(rt, "closeCursor", move(closeCursor));
   module.setProperty(rt, "close", move(close));
+  module.setProperty(rt, "setStatsEnabled", move(setStatsEnabled));
+  module.setProperty(rt, "getStats", move(getStats));
+  module.setProperty(rt, "requestCheckpoint", move(requestCheckpoint));
+  module.setProperty(rt, "getCheckpointStats", move(getCheckpointStats));
+  module.setProperty(rt, "releaseMemory", move(releaseMemory));
+  module.setProperty(rt, "backup", move(backup));
+#ifdef QUICK_SQLITE_HAS_SESSION
+  module.setProperty(rt, "createSession", move(createSession));
+  module.setProperty(rt, "sessionChangeset", move(sessionChangeset));
+  module.setProperty(rt, "closeSession", move(closeSession));
+  module.setProperty(rt, "applyChangeset", move(applyChangeset));
+#else
+  for (auto name : {"createSession", "sessionChangeset", "closeSession",
+                    "applyChangeset"}) {
+    module.setProperty(rt, name, HOSTFN(name, 0) {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite] The session "
+                             "extension is not available in this SQLite "
+                             "build");
+      return {};
+    }));
+  }
+#endif
+  module.setProperty(rt, "interrupt", move(interrupt));
+  module.setProperty(rt, "search", move(search));
+  module.setProperty(rt, "watch", move(watch));
+  module.setProperty(rt, "unwatch", move(unwatch));
 
   module.setProperty(rt, "attach", move(attach));
   module.setProperty(rt, "detach", move(detach));
   module.setProperty(rt, "delete", move(remove));
   module.setProperty(rt, "executeBatch", move(executeBatch));
-  module.setProperty(rt, "loadFileAsync", move(loadFileAsync));
+  module.setProperty(rt, "openPipeline", move(openPipeline));
+  module.setProperty(rt, "executePacked", move(executePacked));
+  module.setProperty(rt, "loadFile", move(loadFileAsync));
+  // Kept for compatibility with the previous name
+  module.setProperty(rt, "loadFileAsync", module.getProperty(rt, "loadFile"));
 
   rt.global().setProperty(rt, "__QuickSQLiteProxy", move(module));
 }
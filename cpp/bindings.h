@@ -9,4 +9,9 @@ void install(jsi::Runtime &rt,
              std::shared_ptr<react::CallInvoker> jsCallInvoker,
              const char *docPath);
 void clearState();
+/**
+ * Releases memory of all open databases, e.g. on a memory warning. Can be
+ * called from any thread, the memory is released from the JS thread.
+ */
+void releaseMemory();
 } // namespace osp
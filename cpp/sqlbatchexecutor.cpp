@@ -4,12 +4,15 @@
 #include "sqlbatchexecutor.h"
 #include "fileUtils.h"
 #include "sqliteExecute.h"
+#include <cctype>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
 void jsiBatchParametersToQuickArguments(jsi::Runtime &rt,
                                         jsi::Array const &batchParams,
-                                        vector<QuickQueryArguments> *commands) {
+                                        vector<QuickBatchCommand> *commands) {
   for (int i = 0; i < batchParams.length(rt); i++) {
     const jsi::Array &command =
         batchParams.getValueAtIndex(rt, i).asObject(rt).asArray(rt);
@@ -17,39 +20,106 @@ void jsiBatchParametersToQuickArguments(jsi::Runtime &rt,
       continue;
     }
 
-    const string query = command.getValueAtIndex(rt, 0).asString(rt).utf8(rt);
+    string query = command.getValueAtIndex(rt, 0).asString(rt).utf8(rt);
     const jsi::Value &commandParams = command.length(rt) > 1
                                           ? command.getValueAtIndex(rt, 1)
                                           : jsi::Value::undefined();
+
+    // Consecutive commands with the same SQL share a prepared statement
+    if (commands->empty() || commands->back().sql != query) {
+      commands->push_back(QuickBatchCommand{.sql = std::move(query)});
+    }
+    auto &paramSets = commands->back().paramSets;
+
     if (!commandParams.isUndefined() &&
         commandParams.asObject(rt).isArray(rt) &&
         commandParams.asObject(rt).asArray(rt).length(rt) > 0 &&
         commandParams.asObject(rt)
             .asArray(rt)
             .getValueAtIndex(rt, 0)
-            .isObject()) {
+            .isObject() &&
+        commandParams.asObject(rt)
+            .asArray(rt)
+            .getValueAtIndex(rt, 0)
+            .asObject(rt)
+            .isArray(rt)) {
       // This arguments is an array of arrays, like a batch update of a single
       // sql command.
       const jsi::Array &batchUpdateParams =
           commandParams.asObject(rt).asArray(rt);
-      for (int x = 0; x < batchUpdateParams.length(rt); x++) {
+      size_t batchUpdateCount = batchUpdateParams.length(rt);
+      paramSets.reserve(paramSets.size() + batchUpdateCount);
+      for (int x = 0; x < batchUpdateCount; x++) {
         const jsi::Value &p = batchUpdateParams.getValueAtIndex(rt, x);
-        vector<QuickValue> params;
-        jsiQueryArgumentsToSequelParam(rt, p, &params);
-        commands->push_back(QuickQueryArguments{
-            query, make_shared<vector<QuickValue>>(params)});
+        paramSets.emplace_back();
+        jsiQueryArgumentsToSequelParam(rt, p, &paramSets.back());
       }
     } else {
-      vector<QuickValue> params;
-      jsiQueryArgumentsToSequelParam(rt, commandParams, &params);
-      commands->push_back(
-          QuickQueryArguments{query, make_shared<vector<QuickValue>>(params)});
+      paramSets.emplace_back();
+      jsiQueryArgumentsToSequelParam(rt, commandParams, &paramSets.back());
+    }
+  }
+}
+
+/**
+ * Executes a command for each of its parameter sets with a single prepared
+ * statement
+ */
+static SQLiteOPResult executeBatchCommand(sqlite3 *db,
+                                          QuickBatchCommand &command,
+                                          PreparedStatementCache *statementCache,
+                                          int *affectedRows) {
+  sqlite3_stmt *statement;
+  int status =
+      statementCache != nullptr
+          ? statementCache->acquire(command.sql, &statement)
+          : sqlite3_prepare_v2(db, command.sql.c_str(), -1, &statement, NULL);
+
+  if (status != SQLITE_OK) {
+    return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "[react-native-quick-sqlite] SQL execution error: " +
+                        string(sqlite3_errmsg(db)),
+    };
+  }
+
+  if (statement == nullptr) {
+    // Empty SQL, nothing to execute
+    return SQLiteOPResult{.type = SQLiteOk};
+  }
+
+  for (auto &params : command.paramSets) {
+    bindStatement(statement, &params);
+
+    // Rows returned by batch statements are ignored
+    int result;
+    do {
+      result = sqlite3_step(statement);
+    } while (result == SQLITE_ROW);
+
+    if (result != SQLITE_DONE) {
+      // The error message is read before the statement is reset
+      string message = sqlite3_errmsg(db);
+      releaseStatement(statement, statementCache);
+      return SQLiteOPResult{
+          .type = SQLiteError,
+          .errorMessage =
+              "[react-native-quick-sqlite] SQL execution error: " + message,
+      };
     }
+
+    *affectedRows += sqlite3_changes(db);
+    sqlite3_reset(statement);
+    sqlite3_clear_bindings(statement);
   }
+
+  releaseStatement(statement, statementCache);
+  return SQLiteOPResult{.type = SQLiteOk};
 }
 
 SequelBatchOperationResult
-sqliteExecuteBatch(sqlite3 *db, vector<QuickQueryArguments> *commands) {
+sqliteExecuteBatch(sqlite3 *db, vector<QuickBatchCommand> *commands,
+                   PreparedStatementCache *statementCache) {
   size_t commandCount = commands->size();
   if (commandCount <= 0) {
     return SequelBatchOperationResult{
@@ -60,30 +130,41 @@ sqliteExecuteBatch(sqlite3 *db, vector<QuickQueryArguments> *commands) {
 
   try {
     int affectedRows = 0;
+    int executedCommands = 0;
+    vector<SequelBatchGroupResult> groups;
+    groups.reserve(commandCount);
 
     sqliteExecuteLiteralWithDB(db, "BEGIN EXCLUSIVE TRANSACTION");
 
-    for (int i = 0; i < commandCount; i++) {
-      auto command = commands->at(i);
-      // We do not provide a datastructure to receive query data because we
-      // don't need/want to handle this results in a batch execution
-      auto result = sqliteExecuteWithDB(db, command.sql, command.params.get(),
-                                        NULL, NULL);
+    for (auto &command : *commands) {
+      auto start = std::chrono::steady_clock::now();
+      int groupAffectedRows = 0;
+      auto result =
+          executeBatchCommand(db, command, statementCache, &groupAffectedRows);
       if (result.type == SQLiteError) {
         sqliteExecuteLiteralWithDB(db, "ROLLBACK");
         return SequelBatchOperationResult{
             .type = SQLiteError,
             .message = result.errorMessage,
         };
-      } else {
-        affectedRows += result.rowsAffected;
       }
+
+      std::chrono::duration<double, std::milli> duration =
+          std::chrono::steady_clock::now() - start;
+      groups.push_back(SequelBatchGroupResult{
+          .commands = (int)command.paramSets.size(),
+          .affectedRows = groupAffectedRows,
+          .durationMs = duration.count(),
+      });
+      affectedRows += groupAffectedRows;
+      executedCommands += command.paramSets.size();
     }
     sqliteExecuteLiteralWithDB(db, "COMMIT");
     return SequelBatchOperationResult{
         .type = SQLiteOk,
         .affectedRows = affectedRows,
-        .commands = (int)commandCount,
+        .commands = executedCommands,
+        .groups = std::move(groups),
     };
   } catch (std::exception &exc) {
     sqliteExecuteLiteralWithDB(db, "ROLLBACK");
@@ -94,44 +175,311 @@ sqliteExecuteBatch(sqlite3 *db, vector<QuickQueryArguments> *commands) {
   }
 }
 
-SequelBatchOperationResult sqliteImportFile(sqlite3 *db,
-                                            const std::string fileLocation) {
-  std::string line;
-  std::ifstream sqFile(fileLocation);
-
-  if (sqFile.is_open()) {
-    try {
-      int affectedRows = 0;
-      int commands = 0;
-      sqliteExecuteLiteralWithDB(db, "BEGIN EXCLUSIVE TRANSACTION");
-      while (std::getline(sqFile, line, '\n')) {
-        if (!line.empty()) {
-          SequelLiteralUpdateResult result =
-              sqliteExecuteLiteralWithDB(db, line);
+/**
+ * Reads a value of packed rows and binds it to the parameter
+ * @returns false if the packed rows are malformed
+ */
+static bool bindPackedValue(sqlite3_stmt *statement, int index,
+                            const uint8_t *data, size_t size, size_t *offset) {
+  if (*offset >= size) {
+    return false;
+  }
+  const uint8_t type = data[(*offset)++];
+  switch (type) {
+  case PACKED_NULL:
+    sqlite3_bind_null(statement, index);
+    return true;
+  case PACKED_INT32: {
+    int32_t value;
+    if (size - *offset < sizeof(value)) {
+      return false;
+    }
+    memcpy(&value, data + *offset, sizeof(value));
+    *offset += sizeof(value);
+    sqlite3_bind_int(statement, index, value);
+    return true;
+  }
+  case PACKED_INT64: {
+    int64_t value;
+    if (size - *offset < sizeof(value)) {
+      return false;
+    }
+    memcpy(&value, data + *offset, sizeof(value));
+    *offset += sizeof(value);
+    sqlite3_bind_int64(statement, index, value);
+    return true;
+  }
+  case PACKED_DOUBLE: {
+    double value;
+    if (size - *offset < sizeof(value)) {
+      return false;
+    }
+    memcpy(&value, data + *offset, sizeof(value));
+    *offset += sizeof(value);
+    sqlite3_bind_double(statement, index, value);
+    return true;
+  }
+  case PACKED_TEXT:
+  case PACKED_BLOB: {
+    uint32_t length;
+    if (size - *offset < sizeof(length)) {
+      return false;
+    }
+    memcpy(&length, data + *offset, sizeof(length));
+    *offset += sizeof(length);
+    if (size - *offset < length) {
+      return false;
+    }
+    // The buffer outlives the step, the value does not need to be copied
+    const void *value = data + *offset;
+    *offset += length;
+    if (type == PACKED_TEXT) {
+      sqlite3_bind_text(statement, index, (const char *)value, length,
+                        SQLITE_STATIC);
+    } else {
+      sqlite3_bind_blob(statement, index, value, length, SQLITE_STATIC);
+    }
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+SequelBatchOperationResult
+sqliteExecutePacked(sqlite3 *db, std::string const &sql, const uint8_t *data,
+                    size_t size, PreparedStatementCache *statementCache) {
+  sqlite3_stmt *statement;
+  int status = statementCache != nullptr
+                   ? statementCache->acquire(sql, &statement)
+                   : sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, NULL);
+
+  if (status != SQLITE_OK || statement == nullptr) {
+    return SequelBatchOperationResult{
+        .type = SQLiteError,
+        .message = "[react-native-quick-sqlite] SQL execution error: " +
+                   string(status != SQLITE_OK ? sqlite3_errmsg(db)
+                                              : "No SQL command provided"),
+    };
+  }
+
+  const int parameterCount = sqlite3_bind_parameter_count(statement);
+  if (parameterCount == 0 && size > 0) {
+    releaseStatement(statement, statementCache);
+    return SequelBatchOperationResult{
+        .type = SQLiteError,
+        .message = "[react-native-quick-sqlite] Packed rows require a "
+                   "statement with parameters",
+    };
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  int affectedRows = 0;
+  int rows = 0;
+  size_t offset = 0;
+  string errorMessage;
+
+  sqliteExecuteLiteralWithDB(db, "BEGIN EXCLUSIVE TRANSACTION");
+  while (offset < size && errorMessage.empty()) {
+    size_t rowOffset = offset;
+    for (int i = 1; i <= parameterCount; i++) {
+      if (!bindPackedValue(statement, i, data, size, &offset)) {
+        errorMessage = "[react-native-quick-sqlite] Malformed packed row at "
+                       "byte " +
+                       std::to_string(rowOffset);
+        break;
+      }
+    }
+    if (!errorMessage.empty()) {
+      break;
+    }
+
+    // Rows returned by the statement are ignored
+    int result;
+    do {
+      result = sqlite3_step(statement);
+    } while (result == SQLITE_ROW);
+
+    if (result != SQLITE_DONE) {
+      errorMessage = "[react-native-quick-sqlite] SQL execution error: " +
+                     string(sqlite3_errmsg(db));
+      break;
+    }
+    affectedRows += sqlite3_changes(db);
+    rows++;
+    sqlite3_reset(statement);
+  }
+
+  // Bindings point into the buffer, they are cleared before it is released
+  sqlite3_reset(statement);
+  sqlite3_clear_bindings(statement);
+  releaseStatement(statement, statementCache);
+
+  if (!errorMessage.empty()) {
+    sqliteExecuteLiteralWithDB(db, "ROLLBACK");
+    return SequelBatchOperationResult{
+        .type = SQLiteError,
+        .message = errorMessage,
+    };
+  }
+  sqliteExecuteLiteralWithDB(db, "COMMIT");
+
+  std::chrono::duration<double, std::milli> duration =
+      std::chrono::steady_clock::now() - start;
+  return SequelBatchOperationResult{
+      .type = SQLiteOk,
+      .affectedRows = affectedRows,
+      .commands = rows,
+      .groups = {SequelBatchGroupResult{
+          .commands = rows,
+          .affectedRows = affectedRows,
+          .durationMs = duration.count(),
+      }},
+  };
+}
+
+#define IMPORT_CHUNK_SIZE 262144 // 256KB
+
+/**
+ * Checks if a statement only controls the transaction which is already
+ * managed by the importer
+ */
+static bool isTransactionStatement(sqlite3_stmt *statement) {
+  const char *sql = sqlite3_sql(statement);
+  while (*sql != '\0' && isspace((unsigned char)*sql)) {
+    sql++;
+  }
+  for (const char *keyword : {"BEGIN", "COMMIT", "END"}) {
+    size_t length = strlen(keyword);
+    if (sqlite3_strnicmp(sql, keyword, length) == 0 &&
+        !isalnum((unsigned char)sql[length]) && sql[length] != '_') {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Executes every statement of the SQL text
+ */
+static SQLiteOPResult executeStatements(sqlite3 *db, std::string const &sql,
+                                        int *affectedRows, int *commands) {
+  const char *remaining = sql.c_str();
+  while (*remaining != '\0') {
+    sqlite3_stmt *statement;
+    const char *tail;
+    if (sqlite3_prepare_v2(db, remaining, -1, &statement, &tail) !=
+        SQLITE_OK) {
+      return SQLiteOPResult{
+          .type = SQLiteError,
+          .errorMessage = "[react-native-quick-sqlite][loadSQLFile] " +
+                          string(sqlite3_errmsg(db)),
+      };
+    }
+    remaining = tail;
+
+    // Whitespace and comments don't produce statements
+    if (statement == nullptr) {
+      continue;
+    }
+
+    if (isTransactionStatement(statement)) {
+      sqlite3_finalize(statement);
+      continue;
+    }
+
+    int result;
+    do {
+      result = sqlite3_step(statement);
+    } while (result == SQLITE_ROW);
+    sqlite3_finalize(statement);
+
+    if (result != SQLITE_DONE) {
+      return SQLiteOPResult{
+          .type = SQLiteError,
+          .errorMessage = "[react-native-quick-sqlite][loadSQLFile] " +
+                          string(sqlite3_errmsg(db)),
+      };
+    }
+
+    *affectedRows += sqlite3_changes(db);
+    (*commands)++;
+  }
+
+  return SQLiteOPResult{.type = SQLiteOk};
+}
+
+SequelBatchOperationResult
+sqliteImportFile(sqlite3 *db, const std::string fileLocation,
+                 SQLImportProgressCallback onProgress) {
+  std::ifstream sqFile(fileLocation, std::ios::binary | std::ios::ate);
+
+  if (!sqFile.is_open()) {
+    return {SQLiteError,
+            "[react-native-quick-sqlite][loadSQLFile] Could not open file", 0,
+            0};
+  }
+
+  size_t totalBytes = sqFile.tellg();
+  sqFile.seekg(0);
+
+  try {
+    int affectedRows = 0;
+    int commands = 0;
+    size_t bytesRead = 0;
+    std::string chunk(IMPORT_CHUNK_SIZE, '\0');
+    // SQL text which has been read but not yet executed
+    std::string pending;
+
+    sqliteExecuteLiteralWithDB(db, "BEGIN EXCLUSIVE TRANSACTION");
+    while (sqFile) {
+      sqFile.read(&chunk[0], chunk.size());
+      size_t chunkLength = sqFile.gcount();
+      if (chunkLength == 0) {
+        break;
+      }
+      pending.append(chunk, 0, chunkLength);
+      bytesRead += chunkLength;
+
+      // Only execute up to the last complete statement, the rest could be
+      // continued in the next chunk
+      size_t end = pending.rfind(';');
+      if (end != std::string::npos) {
+        std::string statements = pending.substr(0, end + 1);
+        if (sqlite3_complete(statements.c_str())) {
+          auto result =
+              executeStatements(db, statements, &affectedRows, &commands);
           if (result.type == SQLiteError) {
             sqliteExecuteLiteralWithDB(db, "ROLLBACK");
-            sqFile.close();
-            return {SQLiteError, result.message, 0, commands};
-          } else {
-            affectedRows += result.affectedRows;
-            commands++;
+            return {SQLiteError, result.errorMessage, 0, commands};
           }
+          pending.erase(0, end + 1);
         }
       }
-      sqFile.close();
-      sqliteExecuteLiteralWithDB(db, "COMMIT");
-      return {SQLiteOk, "", affectedRows, commands};
-    } catch (...) {
-      sqFile.close();
+
+      if (onProgress != nullptr) {
+        onProgress(SQLImportProgress{.bytesRead = bytesRead,
+                                     .totalBytes = totalBytes,
+                                     .commands = commands});
+      }
+    }
+    sqFile.close();
+
+    // The last statement is not required to end with a semicolon
+    auto result = executeStatements(db, pending, &affectedRows, &commands);
+    if (result.type == SQLiteError) {
       sqliteExecuteLiteralWithDB(db, "ROLLBACK");
-      return {SQLiteError,
-              "[react-native-quick-sqlite][loadSQLFile] Unexpected error, "
-              "transaction was rolledback",
-              0, 0};
+      return {SQLiteError, result.errorMessage, 0, commands};
     }
-  } else {
+
+    sqliteExecuteLiteralWithDB(db, "COMMIT");
+    return {SQLiteOk, "", affectedRows, commands};
+  } catch (...) {
+    sqFile.close();
+    sqliteExecuteLiteralWithDB(db, "ROLLBACK");
     return {SQLiteError,
-            "[react-native-quick-sqlite][loadSQLFile] Could not open file", 0,
-            0};
+            "[react-native-quick-sqlite][loadSQLFile] Unexpected error, "
+            "transaction was rolledback",
+            0, 0};
   }
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
 #include "ConnectionPool.h"
 #include "JSIHelper.h"
 #include "sqliteBridge.h"
+#include <functional>
 
 using namespace std;
 using namespace facebook;
@@ -14,18 +15,81 @@ struct QuickQueryArguments {
 };
 
 /**
- * Local Helper method to translate JSI objects QuickQueryArguments
+ * A SQL command which is executed once for each set of parameters.
+ * Consecutive batch entries with the same SQL are grouped into one command so
+ * the statement is only prepared once.
+ */
+struct QuickBatchCommand {
+  string sql;
+  vector<vector<QuickValue>> paramSets;
+};
+
+/**
+ * Local Helper method to translate JSI objects QuickBatchCommand
  * datastructure MUST be called in the JavaScript Thread
  */
 void jsiBatchParametersToQuickArguments(jsi::Runtime &rt,
                                         jsi::Array const &batchParams,
-                                        vector<QuickQueryArguments> *commands);
+                                        vector<QuickBatchCommand> *commands);
 
 /**
- * Execute a batch of commands in a exclusive transaction
+ * Execute a batch of commands in a exclusive transaction.
+ * Each command is prepared once then bound, stepped and reset for each of its
+ * parameter sets.
  */
 SequelBatchOperationResult
-sqliteExecuteBatch(sqlite3 *db, vector<QuickQueryArguments> *commands);
+sqliteExecuteBatch(sqlite3 *db, vector<QuickBatchCommand> *commands,
+                   PreparedStatementCache *statementCache = nullptr);
 
-SequelBatchOperationResult sqliteImportFile(sqlite3 *db,
-                                            std::string const file);
\ No newline at end of file
+/**
+ * Type tags of values in packed rows. Packed rows are a sequence of rows
+ * without any header, each row has one value for every parameter of the
+ * statement. A value is a one byte type tag followed by its data, numbers and
+ * lengths are little endian:
+ * - NULL: no data
+ * - INT32: 4 byte signed integer
+ * - INT64: 8 byte signed integer
+ * - DOUBLE: 8 byte IEEE 754 float
+ * - TEXT: 4 byte unsigned length followed by UTF-8 bytes
+ * - BLOB: 4 byte unsigned length followed by the bytes
+ */
+enum PackedValueType : uint8_t {
+  PACKED_NULL = 0,
+  PACKED_INT32 = 1,
+  PACKED_INT64 = 2,
+  PACKED_DOUBLE = 3,
+  PACKED_TEXT = 4,
+  PACKED_BLOB = 5,
+};
+
+/**
+ * Executes a statement for each row of the packed rows in an exclusive
+ * transaction. Values are bound directly from the buffer, which must stay
+ * alive until this returns.
+ */
+SequelBatchOperationResult
+sqliteExecutePacked(sqlite3 *db, std::string const &sql, const uint8_t *data,
+                    size_t size,
+                    PreparedStatementCache *statementCache = nullptr);
+
+/**
+ * Progress of a SQL file import
+ */
+struct SQLImportProgress {
+  size_t bytesRead;
+  size_t totalBytes;
+  int commands;
+};
+
+typedef std::function<void(SQLImportProgress const &)>
+    SQLImportProgressCallback;
+
+/**
+ * Imports a SQL file in a single exclusive transaction. The file is read in
+ * chunks and split into complete statements, statements can span multiple
+ * lines. Transaction statements in the file (BEGIN, COMMIT, END) are ignored.
+ * The progress callback is called on the calling thread after each chunk.
+ */
+SequelBatchOperationResult
+sqliteImportFile(sqlite3 *db, std::string const file,
+                 SQLImportProgressCallback onProgress = nullptr);
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "sqliteBackup.h"
+#include "sqliteExecute.h"
+#include <thread>
+
+static SQLBackupResult backupError(std::string const &message) {
+  return SQLBackupResult{
+      .type = SQLiteError,
+      .message = "[react-native-quick-sqlite] Backup error: " + message,
+      .totalPages = 0,
+  };
+}
+
+SQLBackupResult sqliteBackupWithDB(sqlite3 *db,
+                                   std::string const &destinationPath,
+                                   int pagesPerStep,
+                                   SQLBackupProgressCallback onProgress) {
+  const char *sourcePath = sqlite3_db_filename(db, "main");
+  if (sourcePath != nullptr && destinationPath == sourcePath) {
+    return backupError("the destination is the source database");
+  }
+
+  // Keep a read transaction open for all steps. The backup copies this
+  // snapshot instead of restarting whenever another connection writes.
+  bool ownsTransaction = sqlite3_get_autocommit(db) != 0;
+  if (ownsTransaction) {
+    sqliteExecuteLiteralWithDB(db, "BEGIN");
+    // BEGIN is deferred, the read transaction starts with the first read
+    auto read =
+        sqliteExecuteLiteralWithDB(db, "SELECT count(*) FROM sqlite_schema");
+    if (read.type == SQLiteError) {
+      sqliteExecuteLiteralWithDB(db, "ROLLBACK");
+      return backupError(read.message);
+    }
+  }
+
+  sqlite3 *destination = nullptr;
+  int openStatus = sqlite3_open_v2(destinationPath.c_str(), &destination,
+                                   SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                                   nullptr);
+  SQLBackupResult result;
+  if (openStatus != SQLITE_OK) {
+    result = backupError(destination == nullptr
+                             ? sqlite3_errstr(openStatus)
+                             : sqlite3_errmsg(destination));
+  } else {
+    sqlite3_backup *backup =
+        sqlite3_backup_init(destination, "main", db, "main");
+    if (backup == nullptr) {
+      result = backupError(sqlite3_errmsg(destination));
+    } else {
+      int status = SQLITE_OK;
+      int busyRetries = 0;
+      while (status == SQLITE_OK || status == SQLITE_BUSY ||
+             status == SQLITE_LOCKED) {
+        status = sqlite3_backup_step(backup, pagesPerStep);
+        if (status == SQLITE_BUSY || status == SQLITE_LOCKED) {
+          // The destination is used by another connection
+          if (++busyRetries > MAX_BACKUP_BUSY_RETRIES) {
+            break;
+          }
+          sqlite3_sleep(10);
+          continue;
+        }
+        busyRetries = 0;
+        if (onProgress != nullptr) {
+          onProgress(SQLBackupProgress{
+              .remainingPages = sqlite3_backup_remaining(backup),
+              .totalPages = sqlite3_backup_pagecount(backup),
+          });
+        }
+        // Let other connection threads run in between steps
+        std::this_thread::yield();
+      }
+      int totalPages = sqlite3_backup_pagecount(backup);
+      int finishStatus = sqlite3_backup_finish(backup);
+
+      if (status == SQLITE_DONE && finishStatus == SQLITE_OK) {
+        result = SQLBackupResult{
+            .type = SQLiteOk,
+            .totalPages = totalPages,
+        };
+      } else {
+        result = backupError(status == SQLITE_DONE
+                                 ? sqlite3_errmsg(destination)
+                                 : sqlite3_errstr(status));
+      }
+    }
+  }
+  sqlite3_close_v2(destination);
+
+  if (ownsTransaction) {
+    sqliteExecuteLiteralWithDB(db, "COMMIT");
+  }
+  return result;
+}
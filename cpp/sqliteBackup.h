@@ -0,0 +1,44 @@
+#include "JSIHelper.h"
+#include "sqlite3.h"
+#include <functional>
+#include <string>
+
+#ifndef sqliteBackup_h
+#define sqliteBackup_h
+
+// Pages copied per backup step if no step size is provided
+#define DEFAULT_BACKUP_PAGES_PER_STEP 256
+// Retries of a backup step while the destination is busy
+#define MAX_BACKUP_BUSY_RETRIES 100
+
+/**
+ * Progress of an online backup, reported after each step
+ */
+struct SQLBackupProgress {
+  int remainingPages;
+  int totalPages;
+};
+
+typedef std::function<void(SQLBackupProgress const &)>
+    SQLBackupProgressCallback;
+
+struct SQLBackupResult {
+  ResultType type;
+  string message;
+  int totalPages;
+};
+
+/**
+ * Copies the main database of `db` to the database file at `destinationPath`
+ * with the online backup API. The backup is made from a single read
+ * transaction, so writes on other connections neither block nor restart it.
+ * Pages are copied in steps of `pagesPerStep`, the thread yields in between.
+ * The progress callback is called on the calling thread after each step.
+ */
+SQLBackupResult sqliteBackupWithDB(sqlite3 *db,
+                                   std::string const &destinationPath,
+                                   int pagesPerStep,
+                                   SQLBackupProgressCallback onProgress =
+                                       nullptr);
+
+#endif
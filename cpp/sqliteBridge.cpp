@@ -38,11 +38,9 @@ SQLiteOPResult generateNotOpenResult(std::string const &dbName) {
 SQLiteOPResult
 sqliteOpenDb(string const dbName, string const docPath,
              void (*contextAvailableCallback)(std::string, ConnectionLockId),
-             void (*updateTableCallback)(void *, int, const char *,
-                                         const char *, sqlite3_int64),
-             void (*onTransactionFinalizedCallback)(
-                 const TransactionCallbackPayload *event),
-             uint32_t numReadConnections) {
+             TransactionFinalizerCallback onTransactionFinalizedCallback,
+             TransactionFinalizerCallback onTransactionCommittedCallback,
+             uint32_t numReadConnections, ConnectionOptions const &options) {
   if (dbMap.count(dbName) == 1) {
     return SQLiteOPResult{
         .type = SQLiteError,
@@ -50,10 +48,11 @@ sqliteOpenDb(string const dbName, string const docPath,
     };
   }
 
-  dbMap[dbName] = new ConnectionPool(dbName, docPath, numReadConnections);
+  dbMap[dbName] =
+      new ConnectionPool(dbName, docPath, numReadConnections, options);
   dbMap[dbName]->setOnContextAvailable(contextAvailableCallback);
-  dbMap[dbName]->setTableUpdateHandler(updateTableCallback);
   dbMap[dbName]->setTransactionFinalizerHandler(onTransactionFinalizedCallback);
+  dbMap[dbName]->setTransactionCommittedHandler(onTransactionCommittedCallback);
 
   return SQLiteOPResult{
       .type = SQLiteOk,
@@ -86,13 +85,13 @@ void sqliteCloseAll() {
 
 SQLiteOPResult sqliteQueueInContext(std::string dbName,
                                     ConnectionLockId const contextId,
-                                    std::function<void(sqlite3 *)> task) {
+                                    ConnectionTask task) {
   if (dbMap.count(dbName) == 0) {
     return generateNotOpenResult(dbName);
   }
 
   ConnectionPool *connection = dbMap[dbName];
-  return connection->queueInContext(contextId, task);
+  return connection->queueInContext(contextId, std::move(task));
 }
 
 void sqliteReleaseLock(std::string const dbName,
@@ -139,6 +138,117 @@ SQLiteOPResult sqliteRequestLock(std::string const dbName,
   };
 }
 
+SQLiteOPResult sqliteExecuteWithLock(std::string const dbName,
+                                     ConcurrentLockType lockType,
+                                     ConnectionTask task,
+                                     TaskRejection reject) {
+  if (dbMap.count(dbName) == 0) {
+    return generateNotOpenResult(dbName);
+  }
+
+  ConnectionPool *connection = dbMap[dbName];
+
+  switch (lockType) {
+  case ConcurrentLockType::ReadLock:
+    connection->executeWithReadLock(std::move(task), std::move(reject));
+    break;
+  case ConcurrentLockType::WriteLock:
+    connection->executeWithWriteLock(std::move(task), std::move(reject));
+    break;
+
+  default:
+    return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "[react-native-quick-sqlite]: Invalid lock type",
+    };
+  }
+
+  return SQLiteOPResult{
+      .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteSetStatsEnabled(std::string const dbName, bool enabled,
+                                     bool profileStatements) {
+  if (dbMap.count(dbName) == 0) {
+    return generateNotOpenResult(dbName);
+  }
+
+  dbMap[dbName]->setStatsEnabled(enabled, profileStatements);
+  return SQLiteOPResult{
+      .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteGetStats(std::string const dbName, bool reset,
+                              std::vector<ConnectionStatsSnapshot> *stats) {
+  if (dbMap.count(dbName) == 0) {
+    return generateNotOpenResult(dbName);
+  }
+
+  *stats = dbMap[dbName]->getStats(reset);
+  return SQLiteOPResult{
+      .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteRequestCheckpoint(std::string const dbName,
+                                       bool truncate) {
+  if (dbMap.count(dbName) == 0) {
+    return generateNotOpenResult(dbName);
+  }
+
+  dbMap[dbName]->requestCheckpoint(truncate);
+  return SQLiteOPResult{
+      .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteGetCheckpointStats(std::string const dbName,
+                                        CheckpointStatsSnapshot *stats) {
+  if (dbMap.count(dbName) == 0) {
+    return generateNotOpenResult(dbName);
+  }
+
+  *stats = dbMap[dbName]->getCheckpointStats();
+  return SQLiteOPResult{
+      .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteReleaseMemory(std::string const dbName) {
+  if (dbMap.count(dbName) == 0) {
+    return generateNotOpenResult(dbName);
+  }
+
+  dbMap[dbName]->releaseMemory();
+  return SQLiteOPResult{
+      .type = SQLiteOk,
+  };
+}
+
+void sqliteReleaseAllMemory() {
+  for (auto const &x : dbMap) {
+    x.second->releaseMemory();
+  }
+}
+
+SQLiteOPResult sqliteInterrupt(std::string const dbName,
+                               ConnectionLockId const contextId) {
+  if (dbMap.count(dbName) == 0) {
+    return generateNotOpenResult(dbName);
+  }
+
+  if (contextId.empty()) {
+    dbMap[dbName]->interruptAll();
+  } else {
+    dbMap[dbName]->interruptContext(contextId);
+  }
+  return SQLiteOPResult{
+      .type = SQLiteOk,
+  };
+}
+
 SQLiteOPResult sqliteAttachDb(string const mainDBName, string const docPath,
                               string const databaseToAttach,
                               string const alias) {
@@ -27,11 +27,9 @@ enum ConcurrentLockType {
 SQLiteOPResult
 sqliteOpenDb(std::string const dbName, std::string const docPath,
              void (*contextAvailableCallback)(std::string, ConnectionLockId),
-             void (*updateTableCallback)(void *, int, const char *,
-                                         const char *, sqlite3_int64),
-             void (*onTransactionFinalizedCallback)(
-                 const TransactionCallbackPayload *event),
-             uint32_t numReadConnections);
+             TransactionFinalizerCallback onTransactionFinalizedCallback,
+             TransactionFinalizerCallback onTransactionCommittedCallback,
+             uint32_t numReadConnections, ConnectionOptions const &options);
 
 SQLiteOPResult sqliteCloseDb(string const dbName);
 
@@ -48,11 +46,54 @@ SQLiteOPResult sqliteRequestLock(std::string const dbName,
 
 SQLiteOPResult sqliteQueueInContext(std::string dbName,
                                     ConnectionLockId const contextId,
-                                    std::function<void(sqlite3 *)>);
+                                    ConnectionTask task);
+
+/**
+ * Runs a task with a read or write lock which is acquired and released
+ * natively. `reject` is called if the task is dropped because the database is
+ * closing.
+ */
+SQLiteOPResult sqliteExecuteWithLock(std::string const dbName,
+                                     ConcurrentLockType lockType,
+                                     ConnectionTask task,
+                                     TaskRejection reject = nullptr);
 
 void sqliteReleaseLock(std::string const dbName,
                        ConnectionLockId const contextId);
 
+SQLiteOPResult sqliteSetStatsEnabled(std::string const dbName, bool enabled,
+                                     bool profileStatements);
+
+/**
+ * Reads the stats of all connections, the write connection is first
+ */
+SQLiteOPResult sqliteGetStats(std::string const dbName, bool reset,
+                              std::vector<ConnectionStatsSnapshot> *stats);
+
+/**
+ * Requests a background checkpoint once the write connection is idle
+ */
+SQLiteOPResult sqliteRequestCheckpoint(std::string const dbName,
+                                       bool truncate);
+
+SQLiteOPResult sqliteGetCheckpointStats(std::string const dbName,
+                                        CheckpointStatsSnapshot *stats);
+
+/**
+ * Releases the page caches of the database connections and closes idle lazy
+ * read connections
+ */
+SQLiteOPResult sqliteReleaseMemory(std::string const dbName);
+
+void sqliteReleaseAllMemory();
+
+/**
+ * Interrupts the statements running in the lock context, or on all
+ * connections of the database if the context ID is empty
+ */
+SQLiteOPResult sqliteInterrupt(std::string const dbName,
+                               ConnectionLockId const contextId);
+
 SQLiteOPResult sqliteAttachDb(string const mainDBName, string const docPath,
                               string const databaseToAttach,
                               string const alias);
@@ -1,4 +1,8 @@
 #include "sqliteExecute.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 
 void bindStatement(sqlite3_stmt *statement, vector<QuickValue> *values) {
   size_t size = values->size();
@@ -8,145 +12,294 @@ void bindStatement(sqlite3_stmt *statement, vector<QuickValue> *values) {
 
   for (int ii = 0; ii < size; ii++) {
     int sqIndex = ii + 1;
-    QuickValue value = values->at(ii);
+    // Text and blobs are bound without copying them, the values are owned by
+    // the caller until the statement is reset
+    QuickValue const &value = (*values)[ii];
     QuickDataType dataType = value.dataType;
     if (dataType == NULL_VALUE) {
       sqlite3_bind_null(statement, sqIndex);
     } else if (dataType == BOOLEAN) {
-      sqlite3_bind_int(statement, sqIndex, value.booleanValue);
+      sqlite3_bind_int(statement, sqIndex, value.booleanValue());
     } else if (dataType == INTEGER) {
-      sqlite3_bind_int(statement, sqIndex, (int)value.doubleOrIntValue);
+      sqlite3_bind_int(statement, sqIndex, (int)value.doubleOrIntValue());
     } else if (dataType == DOUBLE) {
-      sqlite3_bind_double(statement, sqIndex, value.doubleOrIntValue);
+      sqlite3_bind_double(statement, sqIndex, value.doubleOrIntValue());
     } else if (dataType == INT64) {
-      sqlite3_bind_int64(statement, sqIndex, value.int64Value);
+      sqlite3_bind_int64(statement, sqIndex, value.int64Value());
     } else if (dataType == TEXT) {
-      sqlite3_bind_text(statement, sqIndex, value.textValue.c_str(),
-                        value.textValue.length(), SQLITE_TRANSIENT);
+      auto &text = value.textValue();
+      sqlite3_bind_text(statement, sqIndex, text.c_str(), text.length(),
+                        SQLITE_STATIC);
     } else if (dataType == ARRAY_BUFFER) {
-      sqlite3_bind_blob(statement, sqIndex, value.arrayBufferValue.get(),
-                        value.arrayBufferSize, SQLITE_STATIC);
+      auto &buffer = value.arrayBufferValue();
+      sqlite3_bind_blob(statement, sqIndex, buffer->data(), buffer->size(),
+                        SQLITE_STATIC);
     }
   }
 }
 
-SQLiteOPResult
-sqliteExecuteWithDB(sqlite3 *db, std::string const &query,
-                    std::vector<QuickValue> *params,
-                    std::vector<map<std::string, QuickValue>> *results,
-                    std::vector<QuickColumnMetadata> *metadata) {
-  sqlite3_stmt *statement;
+/**
+ * Returns a statement to the cache it was acquired from or finalizes it
+ */
+void releaseStatement(sqlite3_stmt *statement,
+                      PreparedStatementCache *statementCache) {
+  if (statementCache != nullptr) {
+    statementCache->release(statement);
+  } else {
+    sqlite3_finalize(statement);
+  }
+}
 
-  int statementStatus =
-      sqlite3_prepare_v2(db, query.c_str(), -1, &statement, NULL);
+static SQLiteOPResult createExecutionError(sqlite3 *db) {
+  const char *message = sqlite3_errmsg(db);
+  return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] SQL execution error: " +
+                      std::string(message),
+      .rowsAffected = 0,
+      .insertId = 0};
+}
 
-  if (statementStatus ==
-      SQLITE_OK) // statemnet is correct, bind the passed parameters
-  {
-    bindStatement(statement, params);
-  } else {
-    const char *message = sqlite3_errmsg(db);
-    return SQLiteOPResult{
-        .type = SQLiteError,
-        .errorMessage = "[react-native-quick-sqlite] SQL execution error: " +
-                        string(message),
-        .rowsAffected = 0};
+void readStatementColumnNames(sqlite3_stmt *statement,
+                              QuickQueryResult *results) {
+  int count = sqlite3_column_count(statement);
+  results->columnNames.clear();
+  results->columnNames.reserve(count);
+  for (int i = 0; i < count; i++) {
+    results->columnNames.push_back(sqlite3_column_name(statement, i));
   }
+}
 
-  bool isConsuming = true;
-  bool isFailed = false;
+/**
+ * Appends the values of the current row to the result set
+ */
+static void readStatementRow(sqlite3_stmt *statement, int count,
+                             QuickQueryResult *results) {
+  int i = 0;
+  int column_type;
 
-  int result, i, count, column_type;
-  std::string column_name, column_declared_type;
-  std::map<string, QuickValue> row;
+  while (i < count) {
+    column_type = sqlite3_column_type(statement, i);
 
-  while (isConsuming) {
-    result = sqlite3_step(statement);
+    switch (column_type) {
 
-    switch (result) {
-    case SQLITE_ROW:
-      if (results == NULL) {
+    case SQLITE_INTEGER: {
+      if (results->int64Values) {
+        // Converted to a number or a BigInt depending on its size
+        results->values.push_back(
+            createInt64QuickValue(sqlite3_column_int64(statement, i)));
         break;
       }
+      /**
+       * It's not possible to send a int64_t in a jsi::Value because JS
+       * cannot represent the whole number range. Instead, we're sending a
+       * double, which can represent all integers up to 53 bits long, which
+       * is more than what was there before (a 32-bit int).
+       *
+       * See https://github.com/margelo/react-native-quick-sqlite/issues/16
+       * for more context.
+       */
+      double column_value = sqlite3_column_double(statement, i);
+      results->values.push_back(createIntegerQuickValue(column_value));
+      break;
+    }
 
-      i = 0;
-      row = std::map<std::string, QuickValue>();
-      count = sqlite3_column_count(statement);
-
-      while (i < count) {
-        column_type = sqlite3_column_type(statement, i);
-        column_name = sqlite3_column_name(statement, i);
-
-        switch (column_type) {
-
-        case SQLITE_INTEGER: {
-          /**
-           * It's not possible to send a int64_t in a jsi::Value because JS
-           * cannot represent the whole number range. Instead, we're sending a
-           * double, which can represent all integers up to 53 bits long, which
-           * is more than what was there before (a 32-bit int).
-           *
-           * See https://github.com/margelo/react-native-quick-sqlite/issues/16
-           * for more context.
-           */
-          double column_value = sqlite3_column_double(statement, i);
-          row[column_name] = createIntegerQuickValue(column_value);
-          break;
-        }
+    case SQLITE_FLOAT: {
+      double column_value = sqlite3_column_double(statement, i);
+      results->values.push_back(createDoubleQuickValue(column_value));
+      break;
+    }
 
-        case SQLITE_FLOAT: {
-          double column_value = sqlite3_column_double(statement, i);
-          row[column_name] = createDoubleQuickValue(column_value);
-          break;
-        }
+    case SQLITE_TEXT: {
+      const char *column_value =
+          reinterpret_cast<const char *>(sqlite3_column_text(statement, i));
+      int byteLen = sqlite3_column_bytes(statement, i);
+      // Specify length too; in case string contains NULL in the middle
+      // (which SQLite supports!)
+      results->values.push_back(createTextQuickValue(column_value, byteLen));
+      break;
+    }
 
-        case SQLITE_TEXT: {
-          const char *column_value =
-              reinterpret_cast<const char *>(sqlite3_column_text(statement, i));
-          int byteLen = sqlite3_column_bytes(statement, i);
-          // Specify length too; in case string contains NULL in the middle
-          // (which SQLite supports!)
-          row[column_name] =
-              createTextQuickValue(std::string(column_value, byteLen));
-          break;
-        }
+    case SQLITE_BLOB: {
+      const void *blob = sqlite3_column_blob(statement, i);
+      int blob_size = sqlite3_column_bytes(statement, i);
+      // This is the only copy, the buffer is handed to JS as is
+      results->values.push_back(createArrayBufferQuickValue(
+          reinterpret_cast<const uint8_t *>(blob), blob_size));
+      break;
+    }
 
-        case SQLITE_BLOB: {
-          int blob_size = sqlite3_column_bytes(statement, i);
-          const void *blob = sqlite3_column_blob(statement, i);
-          uint8_t *data;
-          memcpy(data, blob, blob_size);
-          row[column_name] = createArrayBufferQuickValue(data, blob_size);
-          break;
-        }
+    case SQLITE_NULL:
+      // Intentionally left blank to switch to default case
+    default:
+      results->values.push_back(createNullQuickValue());
+      break;
+    }
+    i++;
+  }
+  results->rowCount++;
+}
 
-        case SQLITE_NULL:
-          // Intentionally left blank to switch to default case
-        default:
-          row[column_name] = createNullQuickValue();
-          break;
+/**
+ * Resolves the statement column of each requested typed column
+ */
+static SQLiteOPResult resolveTypedColumns(sqlite3_stmt *statement,
+                                          QuickQueryResult *results) {
+  int count = sqlite3_column_count(statement);
+  for (auto &column : results->typedColumns) {
+    column.columnIndex = -1;
+    for (int i = 0; i < count; i++) {
+      if (column.name == sqlite3_column_name(statement, i)) {
+        column.columnIndex = i;
+        break;
+      }
+    }
+    if (column.columnIndex < 0) {
+      return SQLiteOPResult{
+          .type = SQLiteError,
+          .errorMessage = "[react-native-quick-sqlite] Typed column " +
+                          column.name + " is not part of the result set",
+          .rowsAffected = 0,
+          .insertId = 0};
+    }
+  }
+  return SQLiteOPResult{.type = SQLiteOk};
+}
+
+/**
+ * Appends the values of the typed columns of the current row. Values are
+ * written to the typed array bytes directly, NULLs are flagged in the bitmap.
+ * Integers outside of the int32 range fail instead of being truncated.
+ */
+static SQLiteOPResult readStatementTypedRow(sqlite3_stmt *statement,
+                                            QuickQueryResult *results) {
+  size_t row = results->rowCount;
+  for (auto &column : results->typedColumns) {
+    if (row % 8 == 0) {
+      column.nulls.push_back(0);
+    }
+
+    bool isNull =
+        sqlite3_column_type(statement, column.columnIndex) == SQLITE_NULL;
+    if (isNull) {
+      column.nulls[row / 8] |= (uint8_t)(1 << (row % 8));
+    }
+
+    if (column.type == TYPED_INT32) {
+      int64_t value =
+          isNull ? 0 : sqlite3_column_int64(statement, column.columnIndex);
+      if (value < INT32_MIN || value > INT32_MAX) {
+        return SQLiteOPResult{
+            .type = SQLiteError,
+            .errorMessage = "[react-native-quick-sqlite] Typed column " +
+                            column.name + " value " + std::to_string(value) +
+                            " is outside of the int32 range, use float64",
+            .rowsAffected = 0,
+            .insertId = 0};
+      }
+      int32_t int32Value = (int32_t)value;
+      column.values.resize((row + 1) * sizeof(int32_t));
+      memcpy(column.values.data() + row * sizeof(int32_t), &int32Value,
+             sizeof(int32_t));
+    } else {
+      double value =
+          isNull ? 0 : sqlite3_column_double(statement, column.columnIndex);
+      column.values.resize((row + 1) * sizeof(double));
+      memcpy(column.values.data() + row * sizeof(double), &value,
+             sizeof(double));
+    }
+  }
+  results->rowCount++;
+  return SQLiteOPResult{.type = SQLiteOk};
+}
+
+static void readStatementMetadata(sqlite3_stmt *statement,
+                                  std::vector<QuickColumnMetadata> *metadata) {
+  int i = 0;
+  int count = sqlite3_column_count(statement);
+  std::string column_name, column_declared_type;
+  while (i < count) {
+    column_name = sqlite3_column_name(statement, i);
+    const char *tp = sqlite3_column_decltype(statement, i);
+    column_declared_type = tp != NULL ? tp : "UNKNOWN";
+    QuickColumnMetadata meta = {
+        .colunmName = column_name,
+        .columnIndex = i,
+        .columnDeclaredType = column_declared_type,
+    };
+    metadata->push_back(meta);
+    i++;
+  }
+}
+
+/**
+ * Approximate size of the current row, see `QueryLimits`
+ */
+static size_t readRowBytes(sqlite3_stmt *statement, int count) {
+  size_t bytes = 0;
+  for (int i = 0; i < count; i++) {
+    int type = sqlite3_column_type(statement, i);
+    bytes += type == SQLITE_TEXT || type == SQLITE_BLOB
+                 ? sqlite3_column_bytes(statement, i)
+                 : 8;
+  }
+  return bytes;
+}
+
+static SQLiteOPResult createLimitError(std::string const &limit) {
+  return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage =
+          "[react-native-quick-sqlite] Query result exceeded " + limit,
+      .rowsAffected = 0,
+      .insertId = 0};
+}
+
+SQLiteOPResult sqliteStepStatement(sqlite3 *db, sqlite3_stmt *statement,
+                                   QuickQueryResult *results, size_t maxRows,
+                                   bool *isDone, QueryLimits const *limits) {
+  bool isConsuming = true;
+  bool isFailed = false;
+  size_t rowsRead = 0;
+  size_t bytesRead = 0;
+  int count = sqlite3_column_count(statement);
+
+  *isDone = false;
+
+  while (isConsuming && rowsRead < maxRows) {
+    int result = sqlite3_step(statement);
+
+    switch (result) {
+    case SQLITE_ROW:
+      if (results != NULL) {
+        // Checked before the row is copied, a runaway query stops reading early
+        if (limits != nullptr) {
+          if (limits->maxRows > 0 && rowsRead >= limits->maxRows) {
+            return createLimitError("maxRows (" +
+                                    std::to_string(limits->maxRows) + ")");
+          }
+          if (limits->maxBytes > 0) {
+            bytesRead += readRowBytes(statement, count);
+            if (bytesRead > limits->maxBytes) {
+              return createLimitError("maxBytes (" +
+                                      std::to_string(limits->maxBytes) + ")");
+            }
+          }
+        }
+        if (results->typedColumns.empty()) {
+          readStatementRow(statement, count, results);
+        } else {
+          auto rowResult = readStatementTypedRow(statement, results);
+          if (rowResult.type != SQLiteOk) {
+            return rowResult;
+          }
         }
-        i++;
+        rowsRead++;
       }
-      results->push_back(move(row));
       break;
+
     case SQLITE_DONE:
-      if (metadata != NULL) {
-        i = 0;
-        count = sqlite3_column_count(statement);
-        while (i < count) {
-          column_name = sqlite3_column_name(statement, i);
-          const char *tp = sqlite3_column_decltype(statement, i);
-          column_declared_type = tp != NULL ? tp : "UNKNOWN";
-          QuickColumnMetadata meta = {
-              .colunmName = column_name,
-              .columnIndex = i,
-              .columnDeclaredType = column_declared_type,
-          };
-          metadata->push_back(meta);
-          i++;
-        }
-      }
+      *isDone = true;
       isConsuming = false;
       break;
 
@@ -156,18 +309,85 @@ sqliteExecuteWithDB(sqlite3 *db, std::string const &query,
     }
   }
 
-  sqlite3_finalize(statement);
-
   if (isFailed) {
-    const char *message = sqlite3_errmsg(db);
-    return SQLiteOPResult{
-        .type = SQLiteError,
-        .errorMessage = "[react-native-quick-sqlite] SQL execution error: " +
-                        std::string(message),
-        .rowsAffected = 0,
-        .insertId = 0};
+    return createExecutionError(db);
+  }
+
+  return SQLiteOPResult{.type = SQLiteOk};
+}
+
+SQLiteOPResult
+sqliteExecuteWithDB(sqlite3 *db, std::string const &query,
+                    std::vector<QuickValue> *params,
+                    QuickQueryResult *results,
+                    std::vector<QuickColumnMetadata> *metadata,
+                    PreparedStatementCache *statementCache,
+                    QueryStats *queryStats, QueryLimits const *limits) {
+  sqlite3_stmt *statement;
+  auto start = queryStats != nullptr ? std::chrono::steady_clock::now()
+                                     : std::chrono::steady_clock::time_point();
+
+  int statementStatus =
+      statementCache != nullptr
+          ? statementCache->acquire(query, &statement)
+          : sqlite3_prepare_v2(db, query.c_str(), -1, &statement, NULL);
+
+  auto prepared = queryStats != nullptr
+                      ? std::chrono::steady_clock::now()
+                      : std::chrono::steady_clock::time_point();
+
+  if (statementStatus ==
+      SQLITE_OK) // statemnet is correct, bind the passed parameters
+  {
+    bindStatement(statement, params);
+  } else {
+    return createExecutionError(db);
   }
 
+  if (results != NULL) {
+    // Column names are only stored once for the entire result set
+    readStatementColumnNames(statement, results);
+
+    auto typedResult = resolveTypedColumns(statement, results);
+    if (typedResult.type == SQLiteError) {
+      releaseStatement(statement, statementCache);
+      return typedResult;
+    }
+  }
+
+  bool isDone;
+  // The error message is read before the statement is reset
+  auto stepResult = sqliteStepStatement(db, statement, results,
+                                        std::numeric_limits<size_t>::max(),
+                                        &isDone, limits);
+
+  if (queryStats != nullptr) {
+    std::chrono::duration<double, std::milli> prepareTime = prepared - start;
+    std::chrono::duration<double, std::milli> stepTime =
+        std::chrono::steady_clock::now() - prepared;
+    queryStats->prepareMs = prepareTime.count();
+    queryStats->stepMs = stepTime.count();
+    queryStats->rows = results != NULL ? results->rowCount : 0;
+    // Counters are reset, cached statements report each execution separately
+    queryStats->fullscanSteps =
+        sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+    queryStats->sorts =
+        sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_SORT, 1);
+    queryStats->vmSteps =
+        sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_VM_STEP, 1);
+  }
+
+  if (stepResult.type == SQLiteError) {
+    releaseStatement(statement, statementCache);
+    return stepResult;
+  }
+
+  if (metadata != NULL) {
+    readStatementMetadata(statement, metadata);
+  }
+
+  releaseStatement(statement, statementCache);
+
   int changedRowCount = sqlite3_changes(db);
   long long latestInsertRowId = sqlite3_last_insert_rowid(db);
   return SQLiteOPResult{.type = SQLiteOk,
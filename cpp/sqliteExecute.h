@@ -1,16 +1,53 @@
+#include "ConnectionStats.h"
 #include "JSIHelper.h"
+#include "PreparedStatementCache.h"
 #include "sqlite3.h"
 #include <map>
 #include <string>
 #include <vector>
 
+/**
+ * Executes a single statement. Statements are taken from and returned to the
+ * statement cache if one is provided. Timings and statement counters are
+ * measured if `queryStats` is provided. Reading rows stops with an error once
+ * the result exceeds the `limits`.
+ */
 SQLiteOPResult
 sqliteExecuteWithDB(sqlite3 *db, std::string const &query,
                     std::vector<QuickValue> *params,
-                    std::vector<map<std::string, QuickValue>> *results,
-                    std::vector<QuickColumnMetadata> *metadata);
+                    QuickQueryResult *results,
+                    std::vector<QuickColumnMetadata> *metadata,
+                    PreparedStatementCache *statementCache = nullptr,
+                    QueryStats *queryStats = nullptr,
+                    QueryLimits const *limits = nullptr);
+
+/**
+ * Steps a prepared statement, appending up to `maxRows` rows to the results.
+ * `isDone` is set once the statement has no more rows. Fails if the rows read
+ * by this call exceed the `limits`.
+ */
+SQLiteOPResult sqliteStepStatement(sqlite3 *db, sqlite3_stmt *statement,
+                                   QuickQueryResult *results, size_t maxRows,
+                                   bool *isDone,
+                                   QueryLimits const *limits = nullptr);
+
+/**
+ * Stores the column names of a prepared statement in the results
+ */
+void readStatementColumnNames(sqlite3_stmt *statement,
+                              QuickQueryResult *results);
+
+/**
+ * Returns a statement to the cache it was acquired from or finalizes it
+ */
+void releaseStatement(sqlite3_stmt *statement,
+                      PreparedStatementCache *statementCache);
 
 SequelLiteralUpdateResult sqliteExecuteLiteralWithDB(sqlite3 *db,
                                                      std::string const &query);
 
+/**
+ * Binds the values to the statement. Text and blobs are not copied, the values
+ * must outlive any steps of the statement until it is reset.
+ */
 void bindStatement(sqlite3_stmt *statement, std::vector<QuickValue> *values);
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "sqliteSearch.h"
+#include <algorithm>
+
+static std::string quoteIdentifier(std::string const &identifier) {
+  std::string quoted = "\"";
+  for (char c : identifier) {
+    if (c == '"') {
+      quoted += '"';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+std::string buildSearchQuery(SearchOptions const &options,
+                             std::vector<QuickValue> *params) {
+  const std::string table = quoteIdentifier(options.table);
+
+  std::string query = "SELECT rowid";
+  if (options.columns.empty()) {
+    query += ", *";
+  }
+  for (auto const &column : options.columns) {
+    query += ", " + quoteIdentifier(column);
+  }
+
+  // Parameters are bound in the order they appear
+  query += ", bm25(" + table;
+  for (double weight : options.weights) {
+    query += ", ?";
+    params->push_back(createDoubleQuickValue(weight));
+  }
+  query += ") AS rank";
+
+  if (options.includeSnippet) {
+    auto const &snippet = options.snippet;
+    query += ", snippet(" + table + ", ?, ?, ?, ?, ?) AS snippet";
+    params->push_back(createIntegerQuickValue(snippet.column));
+    params->push_back(createTextQuickValue(std::string(snippet.start)));
+    params->push_back(createTextQuickValue(std::string(snippet.end)));
+    params->push_back(createTextQuickValue(std::string(snippet.ellipsis)));
+    params->push_back(createIntegerQuickValue(
+        std::clamp(snippet.tokens, 1, MAX_SNIPPET_TOKENS)));
+  }
+
+  // The sorter only keeps the best `limit` rows
+  query += " FROM " + table + " WHERE " + table +
+           " MATCH ? ORDER BY rank LIMIT ?";
+  params->push_back(createTextQuickValue(std::string(options.match)));
+  params->push_back(createIntegerQuickValue(std::max(options.limit, 0)));
+  return query;
+}
@@ -0,0 +1,47 @@
+#include "JSIHelper.h"
+#include <string>
+#include <vector>
+
+#ifndef sqliteSearch_h
+#define sqliteSearch_h
+
+// Rows returned by a search if no limit is provided
+#define DEFAULT_SEARCH_LIMIT 20
+// Upper bound of snippet tokens supported by FTS5
+#define MAX_SNIPPET_TOKENS 64
+
+struct SearchSnippetOptions {
+  // Column index, -1 picks the best matching column
+  int column = -1;
+  std::string start = "<b>";
+  std::string end = "</b>";
+  std::string ellipsis = "...";
+  int tokens = 10;
+};
+
+/**
+ * A ranked FTS5 query, see `buildSearchQuery`
+ */
+struct SearchOptions {
+  // The FTS5 table
+  std::string table;
+  // The FTS5 query expression
+  std::string match;
+  // Columns to return besides the rowid, all columns if empty
+  std::vector<std::string> columns;
+  // bm25 weights of the table columns, in column order
+  std::vector<double> weights;
+  bool includeSnippet = false;
+  SearchSnippetOptions snippet;
+  int limit = DEFAULT_SEARCH_LIMIT;
+};
+
+/**
+ * Builds a statement returning the best `limit` matches ordered by their
+ * bm25 rank, with `rowid`, `rank` and optionally `snippet` columns. Values
+ * are bound to parameters, identifiers are quoted.
+ */
+std::string buildSearchQuery(SearchOptions const &options,
+                             std::vector<QuickValue> *params);
+
+#endif
@@ -0,0 +1,86 @@
+#include "sqliteSession.h"
+
+#ifdef QUICK_SQLITE_HAS_SESSION
+
+static SQLiteOPResult sessionError(std::string const &message) {
+  return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Session error: " + message,
+  };
+}
+
+SQLiteOPResult sqliteCreateSession(sqlite3 *db,
+                                   std::vector<std::string> const &tables,
+                                   sqlite3_session **session) {
+  int status = sqlite3session_create(db, "main", session);
+  if (status != SQLITE_OK) {
+    return sessionError(sqlite3_errmsg(db));
+  }
+
+  if (tables.empty()) {
+    // Records all tables, including the ones created later
+    status = sqlite3session_attach(*session, nullptr);
+  }
+  for (auto const &table : tables) {
+    status = sqlite3session_attach(*session, table.c_str());
+    if (status != SQLITE_OK) {
+      break;
+    }
+  }
+
+  if (status != SQLITE_OK) {
+    sqlite3session_delete(*session);
+    *session = nullptr;
+    return sessionError(sqlite3_errstr(status));
+  }
+  return SQLiteOPResult{.type = SQLiteOk};
+}
+
+SQLiteOPResult sqliteSessionChangeset(sqlite3_session *session, bool patchset,
+                                      std::vector<uint8_t> *changeset) {
+  int size = 0;
+  void *data = nullptr;
+  int status = patchset ? sqlite3session_patchset(session, &size, &data)
+                        : sqlite3session_changeset(session, &size, &data);
+  if (status != SQLITE_OK) {
+    return sessionError(sqlite3_errstr(status));
+  }
+
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  changeset->assign(bytes, bytes + size);
+  sqlite3_free(data);
+  return SQLiteOPResult{.type = SQLiteOk};
+}
+
+static int resolveConflict(void *context, int conflict,
+                           sqlite3_changeset_iter *iterator) {
+  auto onConflict = *static_cast<ChangesetConflictAction *>(context);
+  switch (onConflict) {
+  case CHANGESET_ABORT:
+    return SQLITE_CHANGESET_ABORT;
+  case CHANGESET_REPLACE:
+    // Rows can only be replaced for data and primary key conflicts
+    if (conflict == SQLITE_CHANGESET_DATA ||
+        conflict == SQLITE_CHANGESET_CONFLICT) {
+      return SQLITE_CHANGESET_REPLACE;
+    }
+    return SQLITE_CHANGESET_OMIT;
+  default:
+    return SQLITE_CHANGESET_OMIT;
+  }
+}
+
+SQLiteOPResult sqliteApplyChangeset(sqlite3 *db,
+                                    std::vector<uint8_t> &changeset,
+                                    ChangesetConflictAction onConflict) {
+  int status = sqlite3changeset_apply(db, (int)changeset.size(),
+                                      changeset.data(), nullptr,
+                                      resolveConflict, &onConflict);
+  if (status != SQLITE_OK) {
+    return sessionError(status == SQLITE_ABORT ? "changeset conflict"
+                                               : sqlite3_errmsg(db));
+  }
+  return SQLiteOPResult{.type = SQLiteOk};
+}
+
+#endif
@@ -0,0 +1,53 @@
+#include "JSIHelper.h"
+#include "sqlite3.h"
+#include <string>
+#include <vector>
+
+#ifndef sqliteSession_h
+#define sqliteSession_h
+
+// The session extension is only available with the bundled SQLite build
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+#define QUICK_SQLITE_HAS_SESSION 1
+#endif
+
+/**
+ * How conflicting changes are resolved when applying a changeset
+ */
+enum ChangesetConflictAction {
+  // Skips the conflicting change
+  CHANGESET_OMIT = 0,
+  // Overwrites the conflicting row, other conflicts are skipped
+  CHANGESET_REPLACE = 1,
+  // Rolls back the whole changeset
+  CHANGESET_ABORT = 2,
+};
+
+#ifdef QUICK_SQLITE_HAS_SESSION
+
+/**
+ * Creates a session recording changes to `tables` of the main database. An
+ * empty list records changes to all tables. The session has to be deleted
+ * before the connection is closed.
+ */
+SQLiteOPResult sqliteCreateSession(sqlite3 *db,
+                                   std::vector<std::string> const &tables,
+                                   sqlite3_session **session);
+
+/**
+ * Collects the changes recorded by the session. Patchsets are smaller but
+ * only contain the primary keys of updated and deleted rows.
+ */
+SQLiteOPResult sqliteSessionChangeset(sqlite3_session *session, bool patchset,
+                                      std::vector<uint8_t> *changeset);
+
+/**
+ * Applies a changeset or patchset in a single savepoint
+ */
+SQLiteOPResult sqliteApplyChangeset(sqlite3 *db,
+                                    std::vector<uint8_t> &changeset,
+                                    ChangesetConflictAction onConflict);
+
+#endif
+
+#endif
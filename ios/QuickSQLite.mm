@@ -3,6 +3,7 @@
 #import <React/RCTBridge+Private.h>
 
 #import <React/RCTUtils.h>
+#import <UIKit/UIKit.h>
 #import <ReactCommon/RCTTurboModule.h>
 #import <jsi/jsi.h>
 
@@ -12,6 +13,19 @@
 
 RCT_EXPORT_MODULE(QuickSQLite)
 
+- (instancetype)init {
+  if (self = [super init]) {
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(didReceiveMemoryWarning)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
+  }
+  return self;
+}
+
+- (void)didReceiveMemoryWarning {
+  osp::releaseMemory();
+}
 
 RCT_EXPORT_BLOCKING_SYNCHRONOUS_METHOD(install) {
   NSLog(@"Installing QuickSQLite module...");
@@ -58,6 +72,7 @@ RCT_EXPORT_BLOCKING_SYNCHRONOUS_METHOD(install) {
 }
 
 - (void)invalidate {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
   osp::clearState();
 }
 
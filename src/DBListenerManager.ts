@@ -1,7 +1,8 @@
-import { registerTransactionHook, registerUpdateHook } from './table-updates';
+import { registerTransactionHook } from './table-updates';
 import {
   BatchedUpdateCallback,
   BatchedUpdateNotification,
+  TableUpdates,
   TransactionEvent,
   UpdateCallback,
   UpdateNotification
@@ -19,7 +20,8 @@ export interface WriteTransactionEvent {
 export interface DBListener extends BaseListener {
   /**
    * Register a listener to be fired for any table change.
-   * Changes inside write locks and transactions are reported immediately.
+   * Changes are reported as soon as they are committed, before the write lock
+   * is released. Changes which are rolled back are not reported.
    */
   rawTableChange: UpdateCallback;
 
@@ -49,16 +51,13 @@ export class DBListenerManagerInternal extends DBListenerManager {
   constructor(protected options: DBListenerManagerOptions) {
     super();
     this.updateBuffer = [];
-    registerUpdateHook(this.options.dbName, (update) => this.handleTableUpdates(update));
-    registerTransactionHook(this.options.dbName, (eventType) => {
-      switch (eventType) {
-        /**
-         * COMMIT hooks occur before the commit is completed. This leads to race conditions.
-         * Only use the rollback event to clear updates.
-         */
-        case TransactionEvent.ROLLBACK:
-          this.transactionReverted();
-          break;
+    registerTransactionHook(this.options.dbName, (eventType, updates) => {
+      /**
+       * Updates are collected natively and are only reported on commit.
+       * Updates from transactions which are rolled back are discarded natively.
+       */
+      if (eventType == TransactionEvent.COMMIT) {
+        this.handleTableUpdates(updates);
       }
 
       this.iterateListeners((l) =>
@@ -90,12 +89,19 @@ export class DBListenerManagerInternal extends DBListenerManager {
     this.iterateListeners((l) => l.tablesUpdated?.(batchedUpdate));
   }
 
-  protected transactionReverted() {
-    // clear updates
-    this.updateBuffer = [];
+  handleTableUpdates(updates: TableUpdates[]) {
+    for (const { table, opType, rowIds } of updates) {
+      if (!rowIds) {
+        this.handleTableUpdate({ table, opType });
+        continue;
+      }
+      for (const rowId of rowIds) {
+        this.handleTableUpdate({ table, opType, rowId });
+      }
+    }
   }
 
-  handleTableUpdates(notification: UpdateNotification) {
+  protected handleTableUpdate(notification: UpdateNotification) {
     // Fire updates for any change
     this.iterateListeners((l) => l.rawTableChange?.({ ...notification }));
 
@@ -4,6 +4,7 @@ import { setupOpen } from './setup-open';
 import { setupTypeORMDriver } from './type-orm';
 
 export * from './types';
+export * from './packed-rows';
 
 declare global {
   function nativeCallSyncHook(): unknown;
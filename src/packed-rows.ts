@@ -0,0 +1,163 @@
+/**
+ * Type tags of values in packed rows, see `packRows`.
+ */
+export enum PackedValueType {
+  NULL = 0,
+  INT32 = 1,
+  INT64 = 2,
+  DOUBLE = 3,
+  TEXT = 4,
+  BLOB = 5
+}
+
+const INT32_MIN = -0x80000000;
+const INT32_MAX = 0x7fffffff;
+
+export type PackedValue = null | undefined | boolean | number | bigint | string | ArrayBuffer | ArrayBufferView;
+
+const REPLACEMENT_CHARACTER = 0xfffd;
+
+function isHighSurrogate(code: number) {
+  return code >= 0xd800 && code < 0xdc00;
+}
+
+function isLowSurrogate(code: number) {
+  return code >= 0xdc00 && code < 0xe000;
+}
+
+/**
+ * Number of UTF-8 bytes of a string. Lone surrogates are encoded as U+FFFD,
+ * like `TextEncoder` does.
+ */
+function utf8Length(value: string): number {
+  let length = 0;
+  for (let i = 0; i < value.length; i++) {
+    const code = value.charCodeAt(i);
+    if (code < 0x80) {
+      length += 1;
+    } else if (code < 0x800) {
+      length += 2;
+    } else if (isHighSurrogate(code) && isLowSurrogate(value.charCodeAt(i + 1))) {
+      // Surrogate pair
+      length += 4;
+      i++;
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+}
+
+function writeUtf8(value: string, bytes: Uint8Array, offset: number): number {
+  for (let i = 0; i < value.length; i++) {
+    let code = value.charCodeAt(i);
+    if (isHighSurrogate(code) && isLowSurrogate(value.charCodeAt(i + 1))) {
+      code = 0x10000 + ((code - 0xd800) << 10) + (value.charCodeAt(++i) - 0xdc00);
+    } else if (isHighSurrogate(code) || isLowSurrogate(code)) {
+      code = REPLACEMENT_CHARACTER;
+    }
+    if (code < 0x80) {
+      bytes[offset++] = code;
+    } else if (code < 0x800) {
+      bytes[offset++] = 0xc0 | (code >> 6);
+      bytes[offset++] = 0x80 | (code & 0x3f);
+    } else if (code < 0x10000) {
+      bytes[offset++] = 0xe0 | (code >> 12);
+      bytes[offset++] = 0x80 | ((code >> 6) & 0x3f);
+      bytes[offset++] = 0x80 | (code & 0x3f);
+    } else {
+      bytes[offset++] = 0xf0 | (code >> 18);
+      bytes[offset++] = 0x80 | ((code >> 12) & 0x3f);
+      bytes[offset++] = 0x80 | ((code >> 6) & 0x3f);
+      bytes[offset++] = 0x80 | (code & 0x3f);
+    }
+  }
+  return offset;
+}
+
+function toBytes(value: ArrayBuffer | ArrayBufferView): Uint8Array {
+  return value instanceof ArrayBuffer
+    ? new Uint8Array(value)
+    : new Uint8Array(value.buffer, value.byteOffset, value.byteLength);
+}
+
+function isInt32(value: number) {
+  return Number.isInteger(value) && value >= INT32_MIN && value <= INT32_MAX;
+}
+
+function packedSize(value: PackedValue): number {
+  if (value == null) {
+    return 1;
+  }
+  switch (typeof value) {
+    case 'boolean':
+      return 5;
+    case 'number':
+      return isInt32(value) ? 5 : 9;
+    case 'bigint':
+      return 9;
+    case 'string':
+      return 5 + utf8Length(value);
+    default:
+      return 5 + value.byteLength;
+  }
+}
+
+/**
+ * Encodes rows of parameters into a single buffer for `executePacked`.
+ *
+ * Each row has one value for every parameter of the statement. A value is a one
+ * byte `PackedValueType` tag followed by its data, numbers and lengths are little
+ * endian. Text and blobs are prefixed with their 4 byte length. Integers outside
+ * of the 32 bit range are encoded as doubles unless they are a `BigInt`.
+ */
+export function packRows(rows: PackedValue[][]): ArrayBuffer {
+  let size = 0;
+  for (const row of rows) {
+    for (const value of row) {
+      size += packedSize(value);
+    }
+  }
+
+  const buffer = new ArrayBuffer(size);
+  const view = new DataView(buffer);
+  const bytes = new Uint8Array(buffer);
+  let offset = 0;
+  for (const row of rows) {
+    for (const value of row) {
+      if (value == null) {
+        view.setUint8(offset++, PackedValueType.NULL);
+      } else if (typeof value == 'boolean') {
+        view.setUint8(offset++, PackedValueType.INT32);
+        view.setInt32(offset, value ? 1 : 0, true);
+        offset += 4;
+      } else if (typeof value == 'number') {
+        if (isInt32(value)) {
+          view.setUint8(offset++, PackedValueType.INT32);
+          view.setInt32(offset, value, true);
+          offset += 4;
+        } else {
+          view.setUint8(offset++, PackedValueType.DOUBLE);
+          view.setFloat64(offset, value, true);
+          offset += 8;
+        }
+      } else if (typeof value == 'bigint') {
+        view.setUint8(offset++, PackedValueType.INT64);
+        view.setBigInt64(offset, value, true);
+        offset += 8;
+      } else if (typeof value == 'string') {
+        view.setUint8(offset++, PackedValueType.TEXT);
+        const end = writeUtf8(value, bytes, offset + 4);
+        view.setUint32(offset, end - offset - 4, true);
+        offset = end;
+      } else {
+        const blob = toBytes(value);
+        view.setUint8(offset++, PackedValueType.BLOB);
+        view.setUint32(offset, blob.byteLength, true);
+        bytes.set(blob, offset + 4);
+        offset += 4 + blob.byteLength;
+      }
+    }
+  }
+  return buffer;
+}
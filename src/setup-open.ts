@@ -1,3 +1,4 @@
+import { AppState } from 'react-native';
 import {
   ISQLite,
   ConcurrentLockType,
@@ -8,8 +9,21 @@ import {
   TransactionContext,
   UpdateCallback,
   SQLBatchTuple,
+  SQLQueryTuple,
   OpenOptions,
-  QueryResult
+  QueryResult,
+  CursorOptions,
+  QueryCursor,
+  TypedColumnType,
+  FileLoadOptions,
+  BackupOptions,
+  StatementPipeline,
+  StatsOptions,
+  WatchOptions,
+  ChangesetSession,
+  ApplyChangesetOptions,
+  SearchOptions,
+  QueryLimits
 } from './types';
 
 import { enhanceQueryResult } from './utils';
@@ -28,6 +42,8 @@ enum TransactionFinalizer {
 
 const DEFAULT_READ_CONNECTIONS = 4;
 
+const DEFAULT_CURSOR_CHUNK_SIZE = 100;
+
 // A incrementing integer ID for tracking lock requests
 let requestIdCounter = 1;
 
@@ -49,6 +65,40 @@ function closeContextLock(dbName: string, id: ContextLockID) {
   proxy.releaseLock(dbName, id);
 }
 
+/**
+ * Creates a cursor which reads rows from the native statement in chunks
+ */
+async function openCursor(
+  dbName: string,
+  lockId: ContextLockID,
+  sql: string,
+  args?: any[],
+  options?: CursorOptions
+): Promise<QueryCursor> {
+  const chunkSize = options?.chunkSize ?? DEFAULT_CURSOR_CHUNK_SIZE;
+  const cursorId = await proxy.openCursor(dbName, lockId, sql, args);
+  // The native cursor is closed once it reports that all rows have been read
+  let done = false;
+
+  return {
+    next: async () => {
+      if (done) {
+        return [];
+      }
+      const result = await proxy.fetchCursor(dbName, lockId, cursorId, chunkSize);
+      done = result.done;
+      return result.rows?._array ?? [];
+    },
+    close: async () => {
+      if (done) {
+        return;
+      }
+      done = true;
+      await proxy.closeCursor(dbName, lockId, cursorId);
+    }
+  };
+}
+
 /**
  * JS callback to trigger queued callbacks when a lock context is available.
  * Declared on the global scope so that C++ can call it.
@@ -66,11 +116,35 @@ global.onLockContextIsAvailable = async (dbName: string, lockId: ContextLockID)
       await record?.callback({
         // @ts-expect-error This is not part of the public interface, but is used internally
         _contextId: lockId,
-        execute: async (sql: string, args?: any[]) => {
-          const result = await proxy.executeInContext(dbName, lockId, sql, args);
+        execute: async (sql: string, args?: any[], limits?: QueryLimits) => {
+          const result = await proxy.executeInContext(dbName, lockId, sql, args, limits);
           enhanceQueryResult(result);
           return result;
-        }
+        },
+        interrupt: () => proxy.interrupt(dbName, lockId),
+        executeCompact: (sql: string, args?: any[]) =>
+          proxy.executeInContext(dbName, lockId, sql, args, { compact: true }),
+        executeTyped: (sql: string, args: any[] | undefined, columns: Record<string, TypedColumnType>) =>
+          proxy.executeInContext(dbName, lockId, sql, args, { typedColumns: columns }),
+        executeLazy: async (sql: string, args?: any[]) => {
+          const result = await proxy.executeInContext(dbName, lockId, sql, args, { lazyRows: true });
+          enhanceQueryResult(result);
+          return result;
+        },
+        pipeline: async (callback: (pipeline: StatementPipeline) => void | Promise<void>) => {
+          const pipeline = proxy.openPipeline(dbName, lockId);
+          try {
+            await callback({ execute: (sql: string, args?: any[]) => pipeline.execute(sql, args) });
+          } catch (ex) {
+            // Queued statements are rolled back, the callback error is reported instead
+            pipeline.finish(true).catch(() => {});
+            throw ex;
+          }
+          const results = await pipeline.finish();
+          results.forEach((result) => enhanceQueryResult(result));
+          return results;
+        },
+        cursor: (sql: string, args?: any[], options?: CursorOptions) => openCursor(dbName, lockId, sql, args, options)
       });
     } catch (ex) {
       console.error(ex);
@@ -185,14 +259,12 @@ export function setupOpen(QuickSQLite: ISQLite) {
         const rollback = finalizedStatement(async () => context.execute('ROLLBACK'));
 
         const wrapExecute =
-          <T>(
-            method: (sql: string, params?: any[]) => Promise<QueryResult>
-          ): ((sql: string, params?: any[]) => Promise<QueryResult>) =>
-          async (sql: string, params?: any[]) => {
+          <A extends any[], T>(method: (...args: A) => Promise<T>): ((...args: A) => Promise<T>) =>
+          async (...args: A) => {
             if (finalized) {
               throw new Error(`Cannot execute in transaction after it has been finalized with commit/rollback.`);
             }
-            return method(sql, params);
+            return method(...args);
           };
 
         try {
@@ -200,7 +272,12 @@ export function setupOpen(QuickSQLite: ISQLite) {
             ...context,
             commit,
             rollback,
-            execute: wrapExecute(context.execute)
+            execute: wrapExecute(context.execute),
+            executeCompact: wrapExecute(context.executeCompact),
+            executeTyped: wrapExecute(context.executeTyped),
+            executeLazy: wrapExecute(context.executeLazy),
+            pipeline: wrapExecute(context.pipeline),
+            cursor: wrapExecute(context.cursor)
           });
           switch (defaultFinalizer) {
             case TransactionFinalizer.COMMIT:
@@ -222,10 +299,39 @@ export function setupOpen(QuickSQLite: ISQLite) {
         }
       };
 
+      // Reset the WAL before the app may be suspended
+      const appStateSubscription = options?.backgroundCheckpoints
+        ? AppState.addEventListener('change', (state) => {
+            if (state == 'background') {
+              QuickSQLite.requestCheckpoint(dbName, true);
+            }
+          })
+        : null;
+
       // Return the concurrent connection object
       return {
-        close: () => QuickSQLite.close(dbName),
-        execute: (sql: string, args?: any[]) => writeLock((context) => context.execute(sql, args)),
+        close: () => {
+          appStateSubscription?.remove();
+          QuickSQLite.close(dbName);
+        },
+        execute: async (sql: string, args?: any[], limits?: QueryLimits) => {
+          const result = await QuickSQLite.executeWithLock(dbName, ConcurrentLockType.WRITE, sql, args, limits);
+          enhanceQueryResult(result);
+          // Table updates are reported before the statement result
+          listenerManager.flushUpdates();
+          return result;
+        },
+        executeRead: async (sql: string, args?: any[], limits?: QueryLimits) => {
+          const result = await QuickSQLite.executeWithLock(dbName, ConcurrentLockType.READ, sql, args, limits);
+          enhanceQueryResult(result);
+          return result;
+        },
+        interrupt: () => QuickSQLite.interrupt(dbName),
+        executeReads: async (queries: SQLQueryTuple[]) => {
+          const results = await QuickSQLite.executeReads(dbName, queries);
+          results.forEach((result) => enhanceQueryResult(result));
+          return results;
+        },
         readLock,
         readTransaction: async <T>(callback: (context: TransactionContext) => Promise<T>, options?: LockOptions) =>
           readLock((context) => wrapTransaction(context, callback)),
@@ -235,11 +341,53 @@ export function setupOpen(QuickSQLite: ISQLite) {
         delete: () => QuickSQLite.delete(dbName, options?.location),
         executeBatch: (commands: SQLBatchTuple[]) =>
           writeLock((context) => QuickSQLite.executeBatch(dbName, commands, (context as any)._contextId)),
+        executePacked: (query: string, rows: ArrayBuffer) =>
+          writeLock((context) => QuickSQLite.executePacked(dbName, query, rows, (context as any)._contextId)),
         attach: (dbNameToAttach: string, alias: string, location?: string) =>
           QuickSQLite.attach(dbName, dbNameToAttach, alias, location),
         detach: (alias: string) => QuickSQLite.detach(dbName, alias),
-        loadFile: (location: string) =>
-          writeLock((context) => QuickSQLite.loadFile(dbName, location, (context as any)._contextId)),
+        loadFile: (location: string, options?: FileLoadOptions) =>
+          writeLock((context) =>
+            QuickSQLite.loadFile(dbName, location, (context as any)._contextId, options?.onProgress)
+          ),
+        setStatsEnabled: (enabled: boolean, options?: StatsOptions) =>
+          QuickSQLite.setStatsEnabled(dbName, enabled, options),
+        getStats: (reset?: boolean) => QuickSQLite.getStats(dbName, reset),
+        requestCheckpoint: (truncate?: boolean) => QuickSQLite.requestCheckpoint(dbName, truncate),
+        getCheckpointStats: () => QuickSQLite.getCheckpointStats(dbName),
+        releaseMemory: () => QuickSQLite.releaseMemory(dbName),
+        backup: (destinationName: string, options?: BackupOptions) =>
+          QuickSQLite.backup(dbName, destinationName, options?.location, options?.pagesPerStep, options?.onProgress),
+        search: async (table: string, query: string, options?: SearchOptions) => {
+          const result = await QuickSQLite.search(dbName, table, query, options);
+          enhanceQueryResult(result);
+          return result;
+        },
+        watch: (query: string, params: any[] | undefined, options: WatchOptions) => {
+          const watchId = QuickSQLite.watch(
+            dbName,
+            query,
+            params,
+            (result) => {
+              enhanceQueryResult(result);
+              options.onResult(result);
+            },
+            options.onError
+          );
+          return () => QuickSQLite.unwatch(watchId);
+        },
+        createSession: async (tables?: string[]): Promise<ChangesetSession> => {
+          const sessionId = await QuickSQLite.createSession(dbName, tables);
+          return {
+            changeset: (options) => QuickSQLite.sessionChangeset(dbName, sessionId, options?.patchset),
+            close: () => QuickSQLite.closeSession(dbName, sessionId)
+          };
+        },
+        applyChangeset: async (changeset: ArrayBuffer, options?: ApplyChangesetOptions) => {
+          await QuickSQLite.applyChangeset(dbName, changeset, options?.onConflict);
+          // The changes are applied with a native lock
+          listenerManager.flushUpdates();
+        },
         listenerManager,
         registerUpdateHook: (callback: UpdateCallback) =>
           listenerManager.registerListener({ rawTableChange: callback }),
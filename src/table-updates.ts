@@ -1,39 +1,23 @@
-import { RowUpdateType, TransactionCallback, TransactionEvent, UpdateCallback } from './types';
+import { TableUpdates, TransactionCallback, TransactionEvent } from './types';
 
-const updateCallbacks: Record<string, UpdateCallback> = {};
 const transactionCallbacks: Record<string, TransactionCallback> = {};
 
-/**
- * Entry point for update callbacks. This is triggered from C++ with params.
- */
-global.triggerUpdateHook = function (dbName: string, table: string, opType: RowUpdateType, rowId: number) {
-  const callback = updateCallbacks[dbName];
-  if (!callback) {
-    return;
-  }
-
-  callback({
-    opType,
-    table,
-    rowId
-  });
-  return null;
-};
-
-export const registerUpdateHook = (dbName: string, callback: UpdateCallback) => {
-  updateCallbacks[dbName] = callback;
-};
-
 /**
  * Entry point for transaction callbacks. This is triggered from C++ with params.
+ * Table updates made during the transaction are provided once, grouped by table
+ * and operation type, when the transaction is committed.
  */
-global.triggerTransactionFinalizerHook = function (dbName: string, eventType: TransactionEvent) {
+global.triggerTransactionFinalizerHook = function (
+  dbName: string,
+  eventType: TransactionEvent,
+  updates?: TableUpdates[]
+) {
   const callback = transactionCallbacks[dbName];
   if (!callback) {
     return;
   }
 
-  callback(eventType);
+  callback(eventType, updates ?? []);
   return null;
 };
 
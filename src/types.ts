@@ -30,6 +30,62 @@ export type QueryResult = {
   metadata?: ColumnMetadata[];
 };
 
+/**
+ * Compact result returned by `executeCompact` {
+ *  columns: The column names of the result set, reported once
+ *  values: A flat row-major array of values. The value for row `r` and
+ *          column `c` is at `values[r * columns.length + c]`
+ *  length: The number of rows in the result set
+ * }
+ *
+ * @interface CompactQueryResult
+ */
+export type CompactQueryResult = {
+  insertId?: number;
+  rowsAffected: number;
+  columns: string[];
+  values: any[];
+  length: number;
+  /**
+   * Query metadata, avaliable only for select query results
+   */
+  metadata?: ColumnMetadata[];
+};
+
+/**
+ * Element type of a column returned by `executeTyped`. Integers outside of the
+ * int32 range fail the query, use `'float64'` for 64 bit values such as
+ * millisecond timestamps.
+ */
+export type TypedColumnType = 'float64' | 'int32';
+
+/**
+ * A single column returned by `executeTyped` {
+ *  values: The value of each row. NULL values are 0
+ *  nulls: A bitmap of NULL values. Row `r` is NULL if bit `r % 8` of `nulls[r >> 3]` is set
+ * }
+ */
+export type TypedColumn = {
+  values: Float64Array | Int32Array;
+  nulls: Uint8Array;
+};
+
+/**
+ * Result returned by `executeTyped`, only the requested columns are returned
+ *
+ * @interface TypedQueryResult
+ */
+export type TypedQueryResult = {
+  insertId?: number;
+  rowsAffected: number;
+  columns: Record<string, TypedColumn>;
+  length: number;
+  /**
+   * Query metadata, avaliable only for select query results
+   */
+  metadata?: ColumnMetadata[];
+};
+
 /**
  * Column metadata
  * Describes some information about columns fetched by the query
@@ -52,13 +108,27 @@ export type ColumnMetadata = {
  */
 export type SQLBatchTuple = [string] | [string, Array<any> | Array<Array<any>>];
 
+export type SQLQueryTuple = [string] | [string, Array<any>];
+
 /**
  * status: 0 or undefined for correct execution, 1 for error
  * message: if status === 1, here you will find error description
  * rowsAffected: Number of affected rows if status == 0
  */
+/**
+ * Execution details of consecutive batch commands which share the same SQL.
+ * The statement is prepared once for the whole group.
+ */
+export type BatchGroupResult = {
+  /** The number of times the statement was executed */
+  commands: number;
+  rowsAffected: number;
+  durationMs: number;
+};
+
 export type BatchQueryResult = {
   rowsAffected?: number;
+  groups?: BatchGroupResult[];
 };
 
 /**
@@ -69,6 +139,134 @@ export interface FileLoadResult extends BatchQueryResult {
   commands?: number;
 }
 
+/**
+ * Result of executing a statement for each packed row
+ */
+export interface PackedExecuteResult extends BatchQueryResult {
+  /** The number of rows executed */
+  commands?: number;
+}
+
+export interface FileLoadProgress {
+  bytesRead: number;
+  totalBytes: number;
+  /** The number of statements executed so far */
+  commands: number;
+}
+
+export interface FileLoadOptions {
+  /**
+   * Called periodically while the file is being imported
+   */
+  onProgress?: (progress: FileLoadProgress) => void;
+}
+
+export interface BackupProgress {
+  /** Pages which still need to be copied. Zero once the backup completed */
+  remainingPages: number;
+  totalPages: number;
+}
+
+export interface BackupOptions {
+  /**
+   * Directory of the backup database, relative to the default database location
+   */
+  location?: string;
+  /**
+   * Pages copied in each step, the worker yields between steps. Defaults to 256.
+   */
+  pagesPerStep?: number;
+  /**
+   * Called after each step of the backup
+   */
+  onProgress?: (progress: BackupProgress) => void;
+}
+
+export interface BackupResult {
+  /** The number of pages in the backup */
+  totalPages: number;
+}
+
+/**
+ * Bounds of a query result. The query fails once its result exceeds one of them,
+ * rows are not read beyond the limit.
+ */
+export interface QueryLimits {
+  maxRows?: number;
+  /** Approximate size of the values, the bytes of text and blobs or 8 bytes for other values */
+  maxBytes?: number;
+}
+
+export interface SearchSnippetOptions {
+  /** Index of the column to take the snippet from. Defaults to -1, the best matching column */
+  column?: number;
+  /** Inserted before each matched phrase. Defaults to `<b>` */
+  start?: string;
+  /** Inserted after each matched phrase. Defaults to `</b>` */
+  end?: string;
+  /** Marks text which was left out. Defaults to `...` */
+  ellipsis?: string;
+  /** Maximum number of tokens in the snippet, from 1 to 64. Defaults to 10 */
+  tokens?: number;
+}
+
+export interface SearchOptions {
+  /** Columns to return besides `rowid`, `rank` and `snippet`. Defaults to all columns */
+  columns?: string[];
+  /** Number of results to return. Defaults to 20 */
+  limit?: number;
+  /** bm25 weights of the table columns, in column order. Defaults to 1 for all columns */
+  weights?: number[];
+  /** Adds a `snippet` column with the matches highlighted */
+  snippet?: SearchSnippetOptions;
+}
+
+/**
+ * How conflicting changes are resolved when applying a changeset
+ */
+export enum ChangesetConflictAction {
+  /** Skips the conflicting change */
+  OMIT = 0,
+  /** Overwrites rows which differ or have the same primary key, other conflicts are skipped */
+  REPLACE = 1,
+  /** Rolls back the whole changeset */
+  ABORT = 2
+}
+
+export interface ChangesetOptions {
+  /**
+   * Creates a patchset, which is smaller but only contains the primary keys of updated and deleted rows
+   */
+  patchset?: boolean;
+}
+
+export interface ApplyChangesetOptions {
+  /** Defaults to `ChangesetConflictAction.ABORT` */
+  onConflict?: ChangesetConflictAction;
+}
+
+/**
+ * Records changes made on the write connection, see `QuickSQLiteConnection.createSession`
+ */
+export interface ChangesetSession {
+  /**
+   * Returns the changes recorded since the session was created. Changes to the same row are combined.
+   */
+  changeset: (options?: ChangesetOptions) => Promise<ArrayBuffer>;
+  close: () => void;
+}
+
+export interface WatchOptions {
+  /**
+   * Called with the first result and whenever the result changed
+   */
+  onResult: (result: QueryResult) => void;
+  /**
+   * Called if running the query failed. The query stays watched.
+   */
+  onError?: (error: Error) => void;
+}
+
 export enum RowUpdateType {
   SQLITE_INSERT = 18,
   SQLITE_DELETE = 9,
@@ -77,7 +275,10 @@ export enum RowUpdateType {
 
 export interface TableUpdateOperation {
   opType: RowUpdateType;
-  rowId: number;
+  /**
+   * Only present if row IDs are reported. See {@link OpenOptions.reportRowIds}.
+   */
+  rowId?: number;
 }
 export interface UpdateNotification extends TableUpdateOperation {
   table: string;
@@ -97,7 +298,16 @@ export enum TransactionEvent {
   ROLLBACK
 }
 
-export type TransactionCallback = (eventType: TransactionEvent) => void;
+/**
+ * Changes made to a table with a single operation type during a transaction.
+ */
+export interface TableUpdates {
+  table: string;
+  opType: RowUpdateType;
+  rowIds?: number[];
+}
+
+export type TransactionCallback = (eventType: TransactionEvent, updates: TableUpdates[]) => void;
 
 export type ContextLockID = string;
 
@@ -116,6 +326,76 @@ export type OpenOptions = {
    * read operations during a write operation.
    */
   numReadConnections?: number;
+  /**
+   * Report the row ID of each changed row in table update notifications.
+   * Disabling this reduces the size of update notifications for large writes.
+   * Defaults to true.
+   */
+  reportRowIds?: boolean;
+  /**
+   * Read integer results as 64 bit values. Integers which can't be represented
+   * exactly as a number are returned as a `BigInt`.
+   * By default integers are returned as numbers, which loses precision above 2^53.
+   * `BigInt` parameters are always accepted.
+   */
+  bigIntResults?: boolean;
+  /**
+   * `PRAGMA cache_size` of each connection. Positive values are a number of
+   * pages, negative values a size in KiB.
+   */
+  cacheSize?: number;
+  /**
+   * `PRAGMA mmap_size` of each connection in bytes. Memory mapped reads avoid
+   * copying pages for large scans.
+   */
+  mmapSize?: number;
+  /**
+   * `PRAGMA wal_autocheckpoint`, the number of WAL pages after which a
+   * checkpoint is run on commit. Zero disables automatic checkpoints.
+   */
+  walAutocheckpoint?: number;
+  /**
+   * Checkpoint the WAL while the write connection is idle and when the app moves
+   * to the background, instead of inline with the commit which crosses the
+   * `walAutocheckpoint` threshold. Once the WAL has grown to four times the
+   * threshold, the checkpoint runs before queued writes. Only applies if read
+   * connections are used. Defaults to false.
+   */
+  backgroundCheckpoints?: boolean;
+  /**
+   * `PRAGMA temp_store` of each connection.
+   */
+  tempStore?: 'default' | 'file' | 'memory';
+  /**
+   * Milliseconds a connection retries for when the database is locked by
+   * another process, see `sqlite3_busy_timeout`.
+   */
+  busyTimeout?: number;
+  /**
+   * Open connections without the SQLite connection mutex (`SQLITE_OPEN_NOMUTEX`).
+   * Every connection is only used by its own worker thread, so the mutex is
+   * not required. Defaults to false.
+   */
+  noMutex?: boolean;
+  /**
+   * Milliseconds after which the thread of an idle read connection exits. The
+   * thread is started again for the next read on that connection, the
+   * connection itself stays open. By default read threads keep running.
+   */
+  readThreadIdleTimeoutMs?: number;
+  /**
+   * Open read connections once they are needed, up to `numReadConnections`, instead
+   * of opening all of them with the database. Idle read connections are closed
+   * again when memory is released. Defaults to false.
+   */
+  lazyReadConnections?: boolean;
+  /**
+   * Run the statements of all connections on a small pool of threads which is
+   * shared by all databases opened with this option, instead of a thread per
+   * connection. Statements of a connection still run in order.
+   * `readThreadIdleTimeoutMs` does not apply. Defaults to false.
+   */
+  sharedWorkers?: boolean;
 };
 
 export type Open = (dbName: string, options?: OpenOptions) => QuickSQLiteConnection;
@@ -127,21 +407,242 @@ export interface ISQLite {
 
   requestLock: (dbName: string, id: ContextLockID, type: ConcurrentLockType) => QueryResult;
   releaseLock(dbName: string, id: ContextLockID): void;
-  executeInContext: (dbName: string, id: ContextLockID, query: string, params: any[]) => Promise<QueryResult>;
+  executeInContext(
+    dbName: string,
+    id: ContextLockID,
+    query: string,
+    params: any[],
+    options?: QueryLimits
+  ): Promise<QueryResult>;
+  executeInContext(
+    dbName: string,
+    id: ContextLockID,
+    query: string,
+    params: any[],
+    options: { compact: true }
+  ): Promise<CompactQueryResult>;
+  executeInContext(
+    dbName: string,
+    id: ContextLockID,
+    query: string,
+    params: any[],
+    options: { typedColumns: Record<string, TypedColumnType> }
+  ): Promise<TypedQueryResult>;
+  executeInContext(
+    dbName: string,
+    id: ContextLockID,
+    query: string,
+    params: any[],
+    options: { lazyRows: true }
+  ): Promise<QueryResult>;
+
+  openCursor: (dbName: string, id: ContextLockID, query: string, params: any[]) => Promise<number>;
+  fetchCursor: (
+    dbName: string,
+    id: ContextLockID,
+    cursorId: number,
+    chunkSize: number
+  ) => Promise<QueryResult & { done: boolean }>;
+  closeCursor: (dbName: string, id: ContextLockID, cursorId: number) => Promise<void>;
+
+  /**
+   * Executes a single statement with a lock which is acquired and released natively.
+   */
+  executeWithLock(
+    dbName: string,
+    type: ConcurrentLockType,
+    query: string,
+    params: any[],
+    options?: QueryLimits
+  ): Promise<QueryResult>;
+  executeReads: (dbName: string, queries: SQLQueryTuple[]) => Promise<QueryResult[]>;
 
   attach: (mainDbName: string, dbNameToAttach: string, alias: string, location?: string) => void;
   detach: (mainDbName: string, alias: string) => void;
 
   executeBatch: (dbName: string, commands: SQLBatchTuple[], id: ContextLockID) => Promise<BatchQueryResult>;
-  loadFile: (dbName: string, location: string, id: ContextLockID) => Promise<FileLoadResult>;
+  openPipeline: (dbName: string, id: ContextLockID) => NativePipeline;
+  executePacked: (dbName: string, query: string, rows: ArrayBuffer, id: ContextLockID) => Promise<PackedExecuteResult>;
+  setStatsEnabled: (dbName: string, enabled: boolean, options?: StatsOptions) => void;
+  getStats: (dbName: string, reset?: boolean) => DBStats;
+  requestCheckpoint: (dbName: string, truncate?: boolean) => void;
+  getCheckpointStats: (dbName: string) => CheckpointStats;
+  releaseMemory: (dbName: string) => void;
+  backup: (
+    dbName: string,
+    destinationName: string,
+    location?: string,
+    pagesPerStep?: number,
+    onProgress?: (progress: BackupProgress) => void
+  ) => Promise<BackupResult>;
+  search: (dbName: string, table: string, query: string, options?: SearchOptions) => Promise<QueryResult>;
+  interrupt: (dbName: string, id?: ContextLockID) => void;
+  watch: (
+    dbName: string,
+    query: string,
+    params: any[] | undefined,
+    onResult: (result: QueryResult) => void,
+    onError?: (error: Error) => void
+  ) => number;
+  unwatch: (watchId: number) => void;
+  createSession: (dbName: string, tables?: string[]) => Promise<number>;
+  sessionChangeset: (dbName: string, sessionId: number, patchset?: boolean) => Promise<ArrayBuffer>;
+  closeSession: (dbName: string, sessionId: number) => void;
+  applyChangeset: (dbName: string, changeset: ArrayBuffer, onConflict?: ChangesetConflictAction) => Promise<void>;
+
+  loadFile: (
+    dbName: string,
+    location: string,
+    id: ContextLockID,
+    onProgress?: (progress: FileLoadProgress) => void
+  ) => Promise<FileLoadResult>;
+}
+
+export interface StatsOptions {
+  /**
+   * Also aggregate the execution time of each distinct SQL statement.
+   * Only a bounded number of statements are tracked per connection.
+   */
+  profileStatements?: boolean;
+}
+
+export interface StatementProfile {
+  sql: string;
+  count: number;
+  totalMs: number;
+  maxMs: number;
+}
+
+/**
+ * Aggregated measurements of a single connection
+ */
+export interface ConnectionStats {
+  /** Tasks executed on the connection's worker thread */
+  tasks: number;
+  /** Total time tasks waited in the queue before being executed */
+  queueWaitMs: number;
+  maxQueueWaitMs: number;
+  queries: number;
+  prepareMs: number;
+  stepMs: number;
+  /** Time spent converting results to JS values */
+  marshallingMs: number;
+  rows: number;
+  fullscanSteps: number;
+  sorts: number;
+  vmSteps: number;
+  statementCacheHits: number;
+  statementCacheMisses: number;
+  /** Only reported if statements are profiled */
+  statements: StatementProfile[];
+}
+
+/**
+ * Background checkpoints of a database
+ */
+export interface CheckpointStats {
+  checkpoints: number;
+  passiveCheckpoints: number;
+  truncateCheckpoints: number;
+  /** Checkpoints which could not checkpoint the entire WAL */
+  busyCheckpoints: number;
+  framesCheckpointed: number;
+  /** Frames in the WAL after the last commit or checkpoint */
+  walFrames: number;
+  totalMs: number;
+  maxMs: number;
+}
+
+export interface DBStats {
+  write: ConnectionStats;
+  read: ConnectionStats[];
 }
 
 export interface LockOptions {
   timeoutMs?: number;
 }
 
+export interface CursorOptions {
+  /**
+   * The maximum number of rows returned by each `next` call.
+   * Defaults to 100.
+   */
+  chunkSize?: number;
+}
+
+/**
+ * Reads the rows of a query incrementally.
+ * The native statement is kept open between reads and is released once all
+ * rows have been read, `close` is called or the lock context is released.
+ */
+export interface QueryCursor {
+  /**
+   * Reads the next chunk of rows.
+   * Resolves with an empty array once all rows have been read.
+   */
+  next: () => Promise<any[]>;
+  close: () => Promise<void>;
+}
+
+/**
+ * Queues statements of a pipeline, see `LockContext.pipeline`
+ */
+export interface StatementPipeline {
+  execute: (sql: string, args?: any[]) => void;
+}
+
+export interface NativePipeline extends StatementPipeline {
+  /**
+   * Releases the savepoint of the pipeline once all statements completed.
+   * @param abort rolls back the statements instead
+   */
+  finish: (abort?: boolean) => Promise<QueryResult[]>;
+}
+
 export interface LockContext {
-  execute: (sql: string, args?: any[]) => Promise<QueryResult>;
+  execute: (sql: string, args?: any[], limits?: QueryLimits) => Promise<QueryResult>;
+  /**
+   * Interrupts the statements currently running in this context, they reject.
+   * Statements executed afterwards are not affected.
+   */
+  interrupt: () => void;
+  /**
+   * Executes a statement and returns the column names once together with a
+   * flat array of values, instead of an object for each row.
+   * This avoids allocating objects and repeating column names for large results.
+   */
+  executeCompact: (sql: string, args?: any[]) => Promise<CompactQueryResult>;
+  /**
+   * Executes a statement and returns the requested numeric columns as typed arrays.
+   * Values are read natively with the requested type, SQLite converts values of
+   * other types. Columns which are not requested are not returned.
+   */
+  executeTyped: (
+    sql: string,
+    args: any[] | undefined,
+    columns: Record<string, TypedColumnType>
+  ) => Promise<TypedQueryResult>;
+  /**
+   * Executes a statement and keeps the rows natively. A row object is only created
+   * when it is read with `rows.item(index)`, so the cost on the JS thread depends
+   * on the rows which are read instead of the size of the result.
+   * Reading `rows._array` converts all rows again on each access.
+   */
+  executeLazy: (sql: string, args?: any[]) => Promise<QueryResult>;
+  /**
+   * Queues the statements passed to `pipeline.execute` without waiting for the
+   * previous results, so they run back to back on the connection. Resolves with
+   * the results of all statements once the callback and all statements completed.
+   * The statements run in a savepoint. If a statement fails, the following
+   * statements are skipped, all statements are rolled back and the promise rejects.
+   */
+  pipeline: (callback: (pipeline: StatementPipeline) => void | Promise<void>) => Promise<QueryResult[]>;
+  /**
+   * Opens a cursor for a query. Rows are read in chunks while the query is
+   * running, the full result is never held in memory.
+   * The cursor can only be used while the lock is held.
+   */
+  cursor: (sql: string, args?: any[], options?: CursorOptions) => Promise<QueryCursor>;
 }
 
 export interface TransactionContext extends LockContext {
@@ -151,7 +652,28 @@ export interface TransactionContext extends LockContext {
 
 export type QuickSQLiteConnection = {
   close: () => void;
-  execute: (sql: string, args?: any[]) => Promise<QueryResult>;
+  /**
+   * Executes a single statement with a write lock.
+   * The lock is acquired and released natively, without waiting for the JS lock callbacks.
+   */
+  execute: (sql: string, args?: any[], limits?: QueryLimits) => Promise<QueryResult>;
+  /**
+   * Executes a single read-only statement with a read lock.
+   * The lock is acquired and released natively, without waiting for the JS lock callbacks.
+   */
+  executeRead: (sql: string, args?: any[], limits?: QueryLimits) => Promise<QueryResult>;
+  /**
+   * Interrupts the statements currently running on all connections, they reject.
+   * Use `LockContext.interrupt` to only interrupt the statements of a lock.
+   */
+  interrupt: () => void;
+  /**
+   * Executes independent read-only statements, each with its own read lock.
+   * Statements run concurrently on the idle read connections.
+   * Resolves with the results in the order of the statements once all of them
+   * are done, or rejects with the first error.
+   */
+  executeReads: (queries: SQLQueryTuple[]) => Promise<QueryResult[]>;
   readLock: <T>(callback: (context: LockContext) => Promise<T>, options?: LockOptions) => Promise<T>;
   readTransaction: <T>(callback: (context: TransactionContext) => Promise<T>, options?: LockOptions) => Promise<T>;
   writeLock: <T>(callback: (context: LockContext) => Promise<T>, options?: LockOptions) => Promise<T>;
@@ -166,12 +688,75 @@ export type QuickSQLiteConnection = {
    */
   detach: (alias: string) => void;
   executeBatch: (commands: SQLBatchTuple[]) => Promise<BatchQueryResult>;
-  loadFile: (location: string) => Promise<FileLoadResult>;
+  /**
+   * Executes the statement for each row of packed parameters in a single transaction.
+   * Rows are encoded with `packRows`, they are decoded and bound on the write
+   * connection's thread instead of being converted value by value on the JS thread.
+   */
+  executePacked: (query: string, rows: ArrayBuffer) => Promise<PackedExecuteResult>;
+  /**
+   * Imports a SQL file in a single transaction.
+   * Statements can span multiple lines, transaction statements in the file are ignored.
+   */
+  loadFile: (location: string, options?: FileLoadOptions) => Promise<FileLoadResult>;
+  /**
+   * Enables or disables collecting stats on all connections.
+   * Stats are collected natively and are only reported when requested with `getStats`.
+   */
+  setStatsEnabled: (enabled: boolean, options?: StatsOptions) => void;
+  /**
+   * Returns the stats collected since they were enabled or last reset.
+   * @param reset clears the stats after reading them
+   */
+  getStats: (reset?: boolean) => DBStats;
+  /**
+   * Requests a checkpoint once the write connection is idle.
+   * A truncating checkpoint resets the WAL file. It does not wait for readers, the
+   * checkpoint is counted as busy if readers are still using the WAL.
+   * Only applies if background checkpoints are enabled.
+   */
+  requestCheckpoint: (truncate?: boolean) => void;
+  getCheckpointStats: () => CheckpointStats;
+  /**
+   * Releases the page caches of all connections and closes idle read connections
+   * if `lazyReadConnections` is enabled. This is also done automatically when
+   * the system reports low memory.
+   */
+  releaseMemory: () => void;
+  /**
+   * Copies the database to `destinationName` while it stays in use. The backup
+   * is a consistent snapshot, made on a read connection without blocking writes.
+   * An existing destination database is overwritten.
+   */
+  backup: (destinationName: string, options?: BackupOptions) => Promise<BackupResult>;
+  /**
+   * Runs a read query and runs it again on a read connection whenever a
+   * committed transaction changed one of the tables it reads. `onResult` is
+   * only called if the result changed. Only changes to ROWID tables are tracked.
+   * @returns a function which stops watching the query
+   */
+  watch: (query: string, params: any[] | undefined, options: WatchOptions) => () => void;
+  /**
+   * Runs an FTS5 full-text query on a read connection. Only the best matches by
+   * `bm25` rank are returned, ordered by their `rank` column.
+   * @param table an FTS5 table
+   * @param query an FTS5 query expression, e.g. `'sqlite AND fast'`
+   */
+  search: (table: string, query: string, options?: SearchOptions) => Promise<QueryResult>;
+  /**
+   * Starts recording changes made on the write connection with the SQLite session extension.
+   * Only changes to tables with a primary key are recorded.
+   * @param tables the tables to record, defaults to all tables
+   */
+  createSession: (tables?: string[]) => Promise<ChangesetSession>;
+  /**
+   * Applies a changeset or patchset created by `ChangesetSession.changeset` on the write connection
+   */
+  applyChangeset: (changeset: ArrayBuffer, options?: ApplyChangesetOptions) => Promise<void>;
   /**
    * Register a callback which will be fired for each ROWID table change event.
-   * Table changes are reported immediately.
-   * Changes might not yet be committed if using a transaction.
-   *  - Listen to transaction events in listenerManager if extra logic is required
+   * Table changes are reported as soon as they are committed, changes which
+   * are rolled back are not reported.
    * For most use cases use `registerTablesChangedHook` instead.
    * @returns a function which will deregister the callback
    */
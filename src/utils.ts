@@ -9,7 +9,8 @@ export const enhanceQueryResult = (result: QueryResult): void => {
       length: 0,
       item: (idx: number) => result.rows._array[idx]
     };
-  } else {
+  } else if (typeof result.rows.item != 'function') {
+    // Lazy rows provide their own item function
     result.rows.item = (idx: number) => result.rows._array[idx];
   }
 };
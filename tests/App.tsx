@@ -3,8 +3,10 @@ import React, { useEffect, useState } from 'react';
 import { SafeAreaView, ScrollView, Text } from 'react-native';
 import 'reflect-metadata';
 
-import { registerBaseTests, runTests } from './tests/index';
+import { registerBaseTests, runBenchmarks, runTests } from './tests/index';
 const TEST_SERVER_URL = 'http://localhost:4243/results';
+const BENCHMARK_SERVER_URL = 'http://localhost:4243/benchmarks';
+const BENCHMARK_MODE = process.env.EXPO_PUBLIC_BENCHMARK === 'true';
 
 export default function App() {
   const [results, setResults] = useState<any>([]);
@@ -38,9 +40,39 @@ export default function App() {
     }
   }, []);
 
+  const executeBenchmarks = React.useCallback(async () => {
+    setResults([]);
+
+    let report: any;
+    try {
+      report = await runBenchmarks();
+      console.log(JSON.stringify(report, null, '\t'));
+      setResults(
+        report.results.map((r: any) => ({
+          description: `${r.name}: ${r.meanMs.toFixed(3)}ms`,
+          type: 'correct'
+        }))
+      );
+    } catch (ex) {
+      console.error(ex);
+      report = { error: `${ex}` };
+    }
+    // Send results to host server
+    await fetch(BENCHMARK_SERVER_URL, {
+      method: 'POST',
+      headers: { 'Content-Type': 'application/json' },
+      body: JSON.stringify(report)
+    });
+  }, []);
+
   useEffect(() => {
-    console.log('Running Tests:');
-    executeTests();
+    if (BENCHMARK_MODE) {
+      console.log('Running Benchmarks:');
+      executeBenchmarks();
+    } else {
+      console.log('Running Tests:');
+      executeTests();
+    }
   }, []);
 
   return (
@@ -9,10 +9,12 @@ const bodyParser = require('body-parser');
 const _ = require('lodash');
 const chalk = require('chalk');
 const { program } = require('commander');
+const fs = require('fs');
 
 const DEFAULT_AVD_NAME = 'macOS-avd-x86_64-29';
 const DEFAULT_SIMULATOR_NAME = 'iPhone 11';
 const DEFAULT_PORT = 4243;
+const DEFAULT_BENCHMARK_OUTPUT = 'benchmark-results.json';
 const TEST_TIMEOUT = 1_800_000; // 30 minutes
 
 program.name('Test Suite').description('Automates tests for React Native app based tests');
@@ -25,6 +27,8 @@ program
     DEFAULT_AVD_NAME
   )
   .option('--port', 'Port to run Express HTTP server for getting results on.', DEFAULT_PORT)
+  .option('--benchmark', 'Run the benchmark suite instead of the tests')
+  .option('--output <file>', 'File to write benchmark results to', DEFAULT_BENCHMARK_OUTPUT)
   .action(async (str, options) => {
     const opts = options.opts();
     const avdName = opts.avdName;
@@ -38,12 +42,13 @@ program
     await spawnP('Reverse Port', `adb`, [`-s`, deviceName, `reverse`, `tcp:${port}`, `tcp:${port}`]);
 
     /** Build and run the Expo app, don't await this, we will await a response. */
+    setBenchmarkMode(opts);
     spawnP('Build Expo App', `yarn`, [`android`, `-d`, avdName]);
 
     const app = express();
     app.use(bodyParser.json());
 
-    const resultsPromise = receiveResults(app);
+    const resultsPromise = opts.benchmark ? receiveBenchmarks(app, opts.output) : receiveResults(app);
 
     /** Listen for results */
     const server = app.listen(port);
@@ -58,6 +63,8 @@ program
   .command('run-ios')
   .option('--simulatorName <name>', 'The iOS simulator name (e.g., "iPhone 11")', DEFAULT_SIMULATOR_NAME)
   .option('--port', 'Port to run Express HTTP server for getting results on.', DEFAULT_PORT)
+  .option('--benchmark', 'Run the benchmark suite instead of the tests')
+  .option('--output <file>', 'File to write benchmark results to', DEFAULT_BENCHMARK_OUTPUT)
   .action(async (str, options) => {
     const opts = options.opts();
     const simulatorName = opts.simulatorName;
@@ -70,12 +77,13 @@ program
     const app = express();
     app.use(bodyParser.json());
 
-    const resultsPromise = receiveResults(app);
+    const resultsPromise = opts.benchmark ? receiveBenchmarks(app, opts.output) : receiveResults(app);
 
     /** Listen for results */
     const server = app.listen(port);
 
     /** Build and run the Expo app, don't await this, we will await a response. */
+    setBenchmarkMode(opts);
     spawnP('Build Expo App', 'yarn', ['ios']);
 
     await resultsPromise;
@@ -175,6 +183,40 @@ async function receiveResults(app) {
   });
 }
 
+/**
+ * The app reads this when it is bundled and runs the benchmark suite instead of the tests
+ */
+function setBenchmarkMode(opts) {
+  process.env.EXPO_PUBLIC_BENCHMARK = opts.benchmark ? 'true' : 'false';
+}
+
+async function receiveBenchmarks(app, output) {
+  return new Promise((resolve, reject) => {
+    const timeout = setTimeout(() => {
+      reject(new Error('Benchmarks timed out'));
+    }, TEST_TIMEOUT);
+
+    app.post('/benchmarks', (req, res) => {
+      clearTimeout(timeout);
+      const report = req.body;
+      if (report.error) {
+        reject(new Error(`Benchmarks failed: ${report.error}`));
+        return res.send('Done');
+      }
+
+      for (let result of report.results) {
+        const mean = result.meanMs.toFixed(3);
+        console.log(chalk.blue(`${result.name}: ${mean}ms (${result.opsPerSecond.toFixed(1)} ops/s)`));
+      }
+      fs.writeFileSync(output, JSON.stringify(report, null, 2));
+      console.log(chalk.green(`Benchmark results written to ${output}`));
+      resolve(report);
+
+      return res.send('Done');
+    });
+  });
+}
+
 function displayResults(results) {
   for (let result of results) {
     switch (result.type) {
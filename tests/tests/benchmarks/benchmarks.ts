@@ -0,0 +1,201 @@
+import { Platform } from 'react-native';
+import { open, QuickSQLiteConnection, SQLBatchTuple } from 'react-native-quick-sqlite';
+
+export type BenchmarkResult = {
+  name: string;
+  iterations: number;
+  totalMs: number;
+  meanMs: number;
+  opsPerSecond: number;
+  /** Rows read or written by each iteration, if applicable */
+  rows?: number;
+};
+
+export type BenchmarkReport = {
+  platform: string;
+  platformVersion: string | number;
+  startedAt: string;
+  /** `PRAGMA compile_options` of the SQLite build which was measured */
+  compileOptions: string[];
+  results: BenchmarkResult[];
+};
+
+const BENCHMARK_DB = 'benchmark';
+const MAX_ROWS = 100_000;
+const READ_POOL_SIZES = [0, 1, 2, 4, 8];
+
+/**
+ * A CPU bound query which doesn't depend on any tables
+ */
+const HEAVY_READ = 'WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 200000) SELECT sum(x) FROM c';
+
+async function measure(
+  name: string,
+  iterations: number,
+  operation: (iteration: number) => Promise<any>,
+  rows?: number
+): Promise<BenchmarkResult> {
+  const start = performance.now();
+  for (let i = 0; i < iterations; i++) {
+    await operation(i);
+  }
+  const totalMs = performance.now() - start;
+  const result = {
+    name,
+    iterations,
+    totalMs,
+    meanMs: totalMs / iterations,
+    opsPerSecond: (iterations / totalMs) * 1000,
+    rows
+  };
+  console.log(`[Benchmark] ${name}: ${result.meanMs.toFixed(3)}ms`);
+  return result;
+}
+
+function openBenchmarkDB(name: string, numReadConnections?: number): QuickSQLiteConnection {
+  const db = open(name, { numReadConnections });
+  return db;
+}
+
+function closeBenchmarkDB(db: QuickSQLiteConnection) {
+  db.close();
+  db.delete();
+}
+
+async function createBenchmarkTable(db: QuickSQLiteConnection) {
+  await db.execute('DROP TABLE IF EXISTS bench');
+  await db.execute('CREATE TABLE bench (id INTEGER PRIMARY KEY, i INTEGER, r REAL, t TEXT, b BLOB)');
+}
+
+function benchmarkRow(id: number) {
+  const blob = new Uint8Array(32).fill(id % 256);
+  return [id, id * 7, id / 3, `row ${id} with a short text value`, blob.buffer];
+}
+
+async function insertBenchmarks(results: BenchmarkResult[]) {
+  const db = openBenchmarkDB(BENCHMARK_DB);
+  try {
+    await createBenchmarkTable(db);
+    const insert = 'INSERT INTO bench (id, i, r, t, b) VALUES (?, ?, ?, ?, ?)';
+
+    results.push(await measure('insert: single statements', 1000, (i) => db.execute(insert, benchmarkRow(i))));
+
+    await createBenchmarkTable(db);
+    const rows = new Array(MAX_ROWS).fill(0).map((_, i) => benchmarkRow(i));
+    const commands: SQLBatchTuple[] = [[insert, rows]];
+    results.push(await measure('insert: executeBatch', 1, () => db.executeBatch(commands), MAX_ROWS));
+  } finally {
+    closeBenchmarkDB(db);
+  }
+}
+
+async function selectBenchmarks(results: BenchmarkResult[]) {
+  const db = openBenchmarkDB(BENCHMARK_DB);
+  try {
+    await createBenchmarkTable(db);
+    await db.executeBatch([
+      [
+        'INSERT INTO bench (id, i, r, t, b) VALUES (?, ?, ?, ?, ?)',
+        new Array(MAX_ROWS).fill(0).map((_, i) => benchmarkRow(i))
+      ]
+    ]);
+
+    const columnMixes = {
+      integer: 'id, i',
+      mixed: 'id, i, r, t',
+      text: 'id, t',
+      blob: 'id, b'
+    };
+
+    for (const limit of [1, 1000, MAX_ROWS]) {
+      const iterations = limit == MAX_ROWS ? 3 : limit == 1 ? 500 : 50;
+      for (const [mix, columns] of Object.entries(columnMixes)) {
+        const sql = `SELECT ${columns} FROM bench LIMIT ${limit}`;
+        results.push(await measure(`select: ${limit} rows, ${mix}`, iterations, () => db.executeRead(sql), limit));
+        results.push(
+          await measure(
+            `select compact: ${limit} rows, ${mix}`,
+            iterations,
+            () => db.readLock((context) => context.executeCompact(sql)),
+            limit
+          )
+        );
+      }
+    }
+
+    results.push(
+      await measure('select: LIKE scan', 20, () => db.executeRead("SELECT count(*) FROM bench WHERE t LIKE '%99 with%'"))
+    );
+    results.push(
+      await measure('select: expression scan', 20, () =>
+        db.executeRead('SELECT sum(i * 2 + r / 3 - (id % 7)) FROM bench WHERE i > id AND r < i')
+      )
+    );
+  } finally {
+    closeBenchmarkDB(db);
+  }
+}
+
+async function lockBenchmarks(results: BenchmarkResult[]) {
+  const db = openBenchmarkDB(BENCHMARK_DB);
+  try {
+    results.push(await measure('lock: readLock round trip', 1000, () => db.readLock(async () => {})));
+    results.push(await measure('lock: writeLock round trip', 1000, () => db.writeLock(async () => {})));
+    results.push(
+      await measure('lock: readLock execute', 1000, () => db.readLock((context) => context.execute('SELECT 1')))
+    );
+    results.push(await measure('lock: native executeRead', 1000, () => db.executeRead('SELECT 1')));
+  } finally {
+    closeBenchmarkDB(db);
+  }
+}
+
+async function readCompileOptions(): Promise<string[]> {
+  const db = openBenchmarkDB(BENCHMARK_DB);
+  try {
+    const result = await db.execute('PRAGMA compile_options');
+    return result.rows?._array.map((row) => row.compile_options) ?? [];
+  } finally {
+    closeBenchmarkDB(db);
+  }
+}
+
+async function readPoolBenchmarks(results: BenchmarkResult[]) {
+  const concurrentReads = 16;
+  for (const numReadConnections of READ_POOL_SIZES) {
+    const db = openBenchmarkDB(`${BENCHMARK_DB}_pool_${numReadConnections}`, numReadConnections);
+    try {
+      results.push(
+        await measure(`read pool: ${numReadConnections} connections, ${concurrentReads} concurrent reads`, 3, () =>
+          Promise.all(new Array(concurrentReads).fill(0).map(() => db.executeRead(HEAVY_READ)))
+        )
+      );
+    } finally {
+      closeBenchmarkDB(db);
+    }
+  }
+}
+
+/**
+ * Measures the native execution and result marshalling paths.
+ * SQL file imports are not measured, the test app has no access to the file system
+ * for creating SQL files.
+ */
+export async function runBenchmarks(): Promise<BenchmarkReport> {
+  const results: BenchmarkResult[] = [];
+  const startedAt = new Date().toISOString();
+  const compileOptions = await readCompileOptions();
+
+  await insertBenchmarks(results);
+  await selectBenchmarks(results);
+  await lockBenchmarks(results);
+  await readPoolBenchmarks(results);
+
+  return {
+    platform: Platform.OS,
+    platformVersion: Platform.Version,
+    startedAt,
+    compileOptions,
+    results
+  };
+}
@@ -1,7 +1,9 @@
 import Chance from 'chance';
 import {
+  BackupProgress,
   BatchedUpdateNotification,
   open,
+  packRows,
   QueryResult,
   QuickSQLite,
   QuickSQLiteConnection,
@@ -132,6 +134,129 @@ export function registerBaseTests() {
       ]);
     });
 
+    it('Query with compact results', async () => {
+      const { id, name, age, networth } = generateUserInfo();
+      await db.execute('INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)', [id, name, age, networth]);
+
+      const res = await db.readLock((context) => context.executeCompact('SELECT * FROM User WHERE id = ?', [id]));
+
+      expect(res.columns).to.eql(['id', 'name', 'age', 'networth']);
+      expect(res.values).to.eql([id, name, age, networth]);
+      expect(res.length).to.equal(1);
+    });
+
+    it('Query with typed columns', async () => {
+      await db.execute('CREATE TABLE IF NOT EXISTS Readings (id INTEGER PRIMARY KEY, ts INTEGER, value REAL)');
+      await db.execute('INSERT INTO Readings (id, ts, value) VALUES (1, 100, 1.5), (2, 200, NULL), (3, NULL, -3.25)');
+
+      const res = await db.readLock((context) =>
+        context.executeTyped('SELECT ts, value, id FROM Readings ORDER BY id', [], { ts: 'int32', value: 'float64' })
+      );
+
+      expect(res.length).to.equal(3);
+      expect(Object.keys(res.columns)).to.eql(['ts', 'value']);
+      expect(res.columns.ts.values).to.be.instanceOf(Int32Array);
+      expect(Array.from(res.columns.ts.values)).to.eql([100, 200, 0]);
+      expect(res.columns.ts.nulls[0]).to.equal(0b100);
+      expect(res.columns.value.values).to.be.instanceOf(Float64Array);
+      expect(Array.from(res.columns.value.values)).to.eql([1.5, 0, -3.25]);
+      expect(res.columns.value.nulls[0]).to.equal(0b010);
+
+      let error: Error | undefined;
+      try {
+        await db.readLock((context) => context.executeTyped('SELECT ts FROM Readings', [], { missing: 'float64' }));
+      } catch (ex) {
+        error = ex as Error;
+      }
+      expect(error?.message).to.include('missing');
+
+      // Millisecond timestamps don't fit into int32
+      await db.execute('INSERT INTO Readings (id, ts, value) VALUES (4, 1700000000000, 0)');
+      error = undefined;
+      try {
+        await db.readLock((context) => context.executeTyped('SELECT ts FROM Readings', [], { ts: 'int32' }));
+      } catch (ex) {
+        error = ex as Error;
+      }
+      expect(error?.message).to.include('int32 range');
+      const timestamps = await db.readLock((context) =>
+        context.executeTyped('SELECT ts FROM Readings WHERE id = 4', [], { ts: 'float64' })
+      );
+      expect(Array.from(timestamps.columns.ts.values)).to.eql([1700000000000]);
+
+      await db.execute('DROP TABLE Readings');
+    });
+
+    it('Query with lazy rows', async () => {
+      for (let id = 1; id <= 100; id++) {
+        await db.execute('INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)', [id, `user${id}`, id, null]);
+      }
+
+      const res = await db.readLock((context) => context.executeLazy('SELECT id, name FROM User ORDER BY id'));
+
+      expect(res.rows!.length).to.equal(100);
+      expect(res.rows!.item(0)).to.eql({ id: 1, name: 'user1' });
+      expect(res.rows!.item(99)).to.eql({ id: 100, name: 'user100' });
+      expect(res.rows!.item(100)).to.equal(undefined);
+      expect(res.rows!._array.length).to.equal(100);
+
+      const empty = await db.readLock((context) => context.executeLazy('SELECT id FROM User WHERE id < 0'));
+      expect(empty.rows!.length).to.equal(0);
+      expect(empty.rows!.item(0)).to.equal(undefined);
+    });
+
+    it('Query with blob values', async () => {
+      await db.execute('CREATE TABLE IF NOT EXISTS Blobs (id INTEGER PRIMARY KEY, data BLOB)');
+      const data = new Uint8Array([0, 1, 2, 253, 254, 255]);
+      await db.execute('INSERT INTO Blobs (id, data) VALUES (1, ?), (2, ?)', [data.buffer, new ArrayBuffer(0)]);
+
+      const res = await db.execute('SELECT data FROM Blobs ORDER BY id');
+      const [first, empty] = res.rows!._array.map((row) => row.data);
+
+      expect(first).to.be.instanceOf(ArrayBuffer);
+      expect(Array.from(new Uint8Array(first))).to.eql(Array.from(data));
+      expect(empty.byteLength).to.equal(0);
+
+      await db.execute('DROP TABLE Blobs');
+    });
+
+    it('Query with a cursor', async () => {
+      const numberOfUsers = 250;
+      await db.executeBatch([
+        [
+          'INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)',
+          new Array(numberOfUsers).fill(0).map((_, i) => [i, 'steven', i, 0])
+        ]
+      ]);
+
+      const chunkSizes = await db.readLock(async (context) => {
+        const cursor = await context.cursor('SELECT * FROM User ORDER BY id', [], { chunkSize: 100 });
+        const sizes: number[] = [];
+        let rows = await cursor.next();
+        while (rows.length > 0) {
+          expect(rows[0].id).to.equal(sizes.length * 100);
+          sizes.push(rows.length);
+          rows = await cursor.next();
+        }
+        return sizes;
+      });
+
+      expect(chunkSizes).to.eql([100, 100, 50]);
+    });
+
+    it('Should close cursors with the lock', async () => {
+      await createTestUser();
+
+      await db.writeLock(async (context) => {
+        const cursor = await context.cursor('SELECT * FROM User', [], { chunkSize: 1 });
+        // The cursor is not exhausted, the statement is released with the lock
+        expect((await cursor.next()).length).to.equal(1);
+      });
+
+      // An open statement would prevent the table from being dropped
+      await db.execute('DROP TABLE User');
+    });
+
     it('Failed insert', async () => {
       const id = chance.string(); // Setting the id to a string will throw an exception, it expects an int
       const { name, age, networth } = generateUserInfo();
@@ -367,6 +492,134 @@ export function registerBaseTests() {
       ]);
     });
 
+    it('Should collect stats when enabled', async () => {
+      await createTestUser();
+      db.setStatsEnabled(true, { profileStatements: true });
+
+      await db.execute('SELECT * FROM User');
+      await db.execute('SELECT * FROM User');
+
+      const stats = db.getStats(true);
+      expect(stats.read.length).to.equal(NUM_READ_CONNECTIONS);
+      expect(stats.write.queries).to.equal(2);
+      expect(stats.write.rows).to.equal(2);
+      expect(stats.write.fullscanSteps).to.be.greaterThan(0);
+      expect(stats.write.statements.find((s) => s.sql == 'SELECT * FROM User')?.count).to.equal(2);
+
+      // Stats were reset and are no longer collected
+      db.setStatsEnabled(false);
+      await db.execute('SELECT * FROM User');
+      expect(db.getStats().write.queries).to.equal(0);
+    });
+
+    it('Should reject loading a missing SQL file', async () => {
+      let error: Error | undefined;
+      try {
+        await db.loadFile('/does/not/exist.sql');
+      } catch (ex) {
+        error = ex as Error;
+      }
+      expect(error?.message).to.include('Could not open file');
+    });
+
+    it('Batch execute groups commands with the same SQL', async () => {
+      const insert = 'INSERT INTO "User" (id, name, age, networth) VALUES(?, ?, ?, ?)';
+      const commands: SQLBatchTuple[] = [
+        [insert, [1, 'a', 1, 0]],
+        [insert, [[2, 'b', 2, 0], [3, 'c', 3, 0]]],
+        ['UPDATE "User" SET age = age + 1'],
+        [insert, [4, 'd', 4, 0]]
+      ];
+
+      const result = await db.executeBatch(commands);
+
+      expect(result.rowsAffected).to.equal(7);
+      expect(result.groups?.map((group) => group.commands)).to.eql([3, 1, 1]);
+      expect(result.groups?.map((group) => group.rowsAffected)).to.eql([3, 3, 1]);
+
+      const res = await db.execute('SELECT id, age FROM User ORDER BY id');
+      expect(res.rows?._array).to.eql([
+        { id: 1, age: 2 },
+        { id: 2, age: 3 },
+        { id: 3, age: 4 },
+        { id: 4, age: 4 }
+      ]);
+    });
+
+    it('Should execute packed rows', async () => {
+      const rows = [
+        [1, 'Ångström 🚀', 20, 1.5],
+        [2, 'b', 30, null],
+        [3, 'c', 40, 2 ** 40]
+      ];
+      const result = await db.executePacked(
+        'INSERT INTO "User" (id, name, age, networth) VALUES(?, ?, ?, ?)',
+        packRows(rows)
+      );
+      expect(result.rowsAffected).to.equal(3);
+      expect(result.commands).to.equal(3);
+
+      const res = await db.execute('SELECT id, name, age, networth FROM User ORDER BY id');
+      expect(res.rows?._array).to.eql(rows.map(([id, name, age, networth]) => ({ id, name, age, networth })));
+
+      // Malformed rows are rolled back
+      const truncated = packRows([[4, 'd', 50, 0]]).slice(0, 10);
+      try {
+        await db.executePacked('INSERT INTO "User" (id, name, age, networth) VALUES(?, ?, ?, ?)', truncated);
+        throw new Error('Did not throw');
+      } catch (ex) {
+        expect(ex.message).to.include('Malformed packed row');
+      }
+      const count = await db.execute('SELECT count(*) AS count FROM User');
+      expect(count.rows!.item(0).count).to.equal(3);
+    });
+
+    it('Should pack text with lone surrogates', async () => {
+      const rows = [
+        [1, 'a\ud800b', 20, null],
+        [2, 'c\udc00', 30, null],
+        [3, '\ud800', 40, null]
+      ];
+      const result = await db.executePacked(
+        'INSERT INTO "User" (id, name, age, networth) VALUES(?, ?, ?, ?)',
+        packRows(rows)
+      );
+      expect(result.rowsAffected).to.equal(3);
+
+      // Lone surrogates are replaced like TextEncoder does
+      const res = await db.execute('SELECT name FROM User ORDER BY id');
+      expect(res.rows?._array.map((row) => row.name)).to.eql(['a�b', 'c�', '�']);
+    });
+
+    it('Should execute pipelined statements', async () => {
+      const insert = 'INSERT INTO "User" (id, name, age, networth) VALUES(?, ?, ?, ?)';
+      const results = await db.writeTransaction((tx) =>
+        tx.pipeline((pipeline) => {
+          pipeline.execute(insert, [1, 'a', 1, 0]);
+          pipeline.execute(insert, [2, 'b', 2, 0]);
+          pipeline.execute('SELECT count(*) AS count FROM User');
+        })
+      );
+      expect(results.length).to.equal(3);
+      expect(results[0].rowsAffected).to.equal(1);
+      expect(results[2].rows!.item(0).count).to.equal(2);
+
+      try {
+        await db.writeLock((context) =>
+          context.pipeline((pipeline) => {
+            pipeline.execute(insert, [3, 'c', 3, 0]);
+            pipeline.execute(insert, [1, 'duplicate', 1, 0]);
+            pipeline.execute(insert, [4, 'd', 4, 0]);
+          })
+        );
+        throw new Error('Did not throw');
+      } catch (ex) {
+        expect(ex.message).to.include('pipeline statement 1');
+      }
+      const res = await db.execute('SELECT id FROM User ORDER BY id');
+      expect(res.rows?._array).to.eql([{ id: 1 }, { id: 2 }]);
+    });
+
     it('Read lock should be read only', async () => {
       const { id, name, age, networth } = generateUserInfo();
 
@@ -494,6 +747,554 @@ export function registerBaseTests() {
       expect(update.table).to.equal('User');
     });
 
+    it('Should re-run watched queries when their tables change', async () => {
+      const counts: number[] = [];
+      let onResult = () => {};
+      const stopWatching = db.watch('SELECT COUNT(*) as count FROM User', [], {
+        onResult: (result) => {
+          counts.push(result.rows?.item(0).count);
+          onResult();
+        }
+      });
+      const nextResult = () => new Promise<void>((resolve) => (onResult = resolve));
+
+      await nextResult();
+      expect(counts).to.deep.equal([0]);
+
+      const updated = nextResult();
+      await createTestUser();
+      await updated;
+      expect(counts).to.deep.equal([0, 1]);
+
+      // Neither unrelated tables nor unchanged results are reported
+      await db.execute('INSERT INTO t1(a, b, c) VALUES(?, ?, ?)', [1, 2, 'c']);
+      await db.execute('UPDATE User SET age = age');
+      await new Promise((resolve) => setTimeout(resolve, 100));
+      expect(counts).to.deep.equal([0, 1]);
+
+      stopWatching();
+      await createTestUser();
+      await new Promise((resolve) => setTimeout(resolve, 100));
+      expect(counts).to.deep.equal([0, 1]);
+    });
+
+    it('Should re-run watched queries once the commit is visible', async () => {
+      const counts: number[] = [];
+      let onResult = () => {};
+      const stopWatching = db.watch('SELECT COUNT(*) as count FROM User', [], {
+        onResult: (result) => {
+          counts.push(result.rows?.item(0).count);
+          onResult();
+        }
+      });
+      const nextResult = () => new Promise<void>((resolve) => (onResult = resolve));
+
+      try {
+        await nextResult();
+        for (let i = 1; i <= 20; i++) {
+          const updated = nextResult();
+          await db.writeTransaction((tx) => createTestUser(tx));
+          // A run which read the previous snapshot has an unchanged result, which is not reported
+          await Promise.race([updated, new Promise((resolve) => setTimeout(resolve, 1000))]);
+          expect(counts[counts.length - 1]).to.equal(i);
+        }
+      } finally {
+        stopWatching();
+      }
+    });
+
+    it('Should stop watching queries from their callbacks', async () => {
+      let results = 0;
+      const stopWatching = db.watch('SELECT COUNT(*) as count FROM User', [], {
+        onResult: () => {
+          results++;
+          stopWatching();
+        }
+      });
+
+      await new Promise((resolve) => setTimeout(resolve, 100));
+      await createTestUser();
+      await new Promise((resolve) => setTimeout(resolve, 100));
+      expect(results).to.equal(1);
+    });
+
+    it('Should detect schema changes after watching a query', async () => {
+      // Watched queries run on the same connection as the statements below
+      const singleConnection = open('watched_schema_changes', {
+        numReadConnections: 0
+      });
+      try {
+        await singleConnection.execute('CREATE TABLE IF NOT EXISTS Data (id INTEGER PRIMARY KEY, value TEXT)');
+        await singleConnection.execute('SELECT * FROM Data');
+
+        let stopWatching = () => {};
+        await new Promise<void>((resolve) => {
+          stopWatching = singleConnection.watch('SELECT COUNT(*) as count FROM Data', [], {
+            onResult: () => resolve()
+          });
+        });
+        stopWatching();
+
+        // Changing the schema clears the cached statements of the connection
+        await singleConnection.execute('ALTER TABLE Data ADD COLUMN extra TEXT');
+        const misses = singleConnection.getStats().write.statementCacheMisses;
+        await singleConnection.execute('SELECT * FROM Data');
+        expect(singleConnection.getStats().write.statementCacheMisses).to.equal(misses + 1);
+      } finally {
+        singleConnection.close();
+        singleConnection.delete();
+      }
+    });
+
+    it('Should execute single statements with native locks', async () => {
+      const { id, name, age, networth } = generateUserInfo();
+
+      // Statements with native locks are queued behind locks requested from JS
+      const lockPromise = db.writeLock(async (tx) => {
+        await new Promise((resolve) => setTimeout(resolve, 100));
+        await tx.execute('INSERT INTO "User" (id, name, age, networth) VALUES(?, ?, ?, ?)', [id, name, age, networth]);
+      });
+      const countPromise = db.execute('SELECT COUNT(*) as count FROM User');
+      await lockPromise;
+
+      expect((await countPromise).rows?.item(0).count).to.equal(1);
+
+      const res = await db.executeRead('SELECT name FROM User WHERE id = ?', [id]);
+      expect(res.rows?._array).to.deep.equal([{ name }]);
+
+      let error: Error | undefined;
+      try {
+        await db.executeRead('INSERT INTO "User" (id, name, age, networth) VALUES(?, ?, ?, ?)', [id + 1, name, age, 0]);
+      } catch (ex) {
+        error = ex as Error;
+      }
+      expect(error).to.be.instanceOf(Error);
+    });
+
+    it('Should execute independent reads in parallel', async () => {
+      const users = await Promise.all([createTestUser(), createTestUser(), createTestUser()]);
+      const { id } = (await db.execute('SELECT id FROM User LIMIT 1')).rows!.item(0);
+
+      const [count, user, names] = await db.executeReads([
+        ['SELECT COUNT(*) as count FROM User'],
+        ['SELECT id FROM User WHERE id = ?', [id]],
+        ['SELECT name FROM User']
+      ]);
+
+      expect(count.rows?.item(0).count).to.equal(users.length);
+      expect(user.rows?.item(0).id).to.equal(id);
+      expect(names.rows?.length).to.equal(users.length);
+
+      let error: Error | undefined;
+      try {
+        await db.executeReads([['SELECT * FROM User'], ['SELECT * FROM DoesNotExist']]);
+      } catch (ex) {
+        error = ex as Error;
+      }
+      expect(error).to.be.instanceOf(Error);
+    });
+
+    it('Should read 64 bit integers with bigIntResults', async () => {
+      const bigIntConnection = open('big_int_results', { bigIntResults: true });
+      try {
+        await bigIntConnection.execute('CREATE TABLE IF NOT EXISTS Ids (id INTEGER PRIMARY KEY, small INTEGER)');
+        const snowflake = BigInt('1234567890123456789');
+        await bigIntConnection.execute('INSERT INTO Ids (id, small) VALUES (?, ?)', [snowflake, 42]);
+
+        const res = await bigIntConnection.execute('SELECT id, small, CAST(id AS TEXT) AS text FROM Ids');
+        const row = res.rows!.item(0);
+        expect(row.id).to.equal(snowflake);
+        expect(row.small).to.equal(42);
+        expect(row.text).to.equal('1234567890123456789');
+      } finally {
+        bigIntConnection.close();
+        bigIntConnection.delete();
+      }
+    });
+
+    it('Should apply connection options', async () => {
+      const tunedConnection = open('tuned_connection', {
+        cacheSize: -4096,
+        mmapSize: 1048576,
+        walAutocheckpoint: 500,
+        tempStore: 'memory',
+        busyTimeout: 2000,
+        noMutex: true
+      });
+      try {
+        for (const execute of [tunedConnection.execute, tunedConnection.executeRead]) {
+          const cacheSize = await execute('PRAGMA cache_size');
+          expect(cacheSize.rows!.item(0).cache_size).to.equal(-4096);
+          const mmapSize = await execute('PRAGMA mmap_size');
+          expect(mmapSize.rows!.item(0).mmap_size).to.equal(1048576);
+          const tempStore = await execute('PRAGMA temp_store');
+          expect(tempStore.rows!.item(0).temp_store).to.equal(2);
+          const busyTimeout = await execute('PRAGMA busy_timeout');
+          expect(busyTimeout.rows!.item(0).timeout).to.equal(2000);
+        }
+        const autocheckpoint = await tunedConnection.execute('PRAGMA wal_autocheckpoint');
+        expect(autocheckpoint.rows!.item(0).wal_autocheckpoint).to.equal(500);
+      } finally {
+        tunedConnection.close();
+        tunedConnection.delete();
+      }
+    });
+
+    it('Should checkpoint the WAL in the background', async () => {
+      const checkpointConnection = open('background_checkpoints', {
+        backgroundCheckpoints: true,
+        walAutocheckpoint: 10
+      });
+      try {
+        await checkpointConnection.execute('CREATE TABLE IF NOT EXISTS Data (id INTEGER PRIMARY KEY, value TEXT)');
+        for (let i = 0; i < 20; i++) {
+          await checkpointConnection.execute('INSERT INTO Data (value) VALUES (?)', ['x'.repeat(4096)]);
+        }
+        // The checkpoint runs once the write connection is released
+        await checkpointConnection.writeLock(async () => {});
+
+        const stats = checkpointConnection.getCheckpointStats();
+        expect(stats.checkpoints).to.be.greaterThan(0);
+        expect(stats.framesCheckpointed).to.be.greaterThan(0);
+
+        checkpointConnection.requestCheckpoint(true);
+        await checkpointConnection.writeLock(async () => {});
+        const truncated = checkpointConnection.getCheckpointStats();
+        expect(truncated.truncateCheckpoints).to.equal(1);
+        expect(truncated.walFrames).to.equal(0);
+      } finally {
+        checkpointConnection.close();
+        checkpointConnection.delete();
+      }
+    });
+
+    it('Should checkpoint the WAL while writes are queued', async () => {
+      const checkpointConnection = open('overdue_checkpoints', {
+        backgroundCheckpoints: true,
+        walAutocheckpoint: 10
+      });
+      try {
+        await checkpointConnection.execute('CREATE TABLE IF NOT EXISTS Data (id INTEGER PRIMARY KEY, value TEXT)');
+        // The write connection is not idle until all inserts completed
+        await Promise.all(
+          Array.from({ length: 100 }, () =>
+            checkpointConnection.execute('INSERT INTO Data (value) VALUES (?)', ['x'.repeat(4096)])
+          )
+        );
+
+        const stats = checkpointConnection.getCheckpointStats();
+        expect(stats.checkpoints).to.be.greaterThan(1);
+        expect(stats.walFrames).to.be.lessThan(100);
+      } finally {
+        checkpointConnection.close();
+        checkpointConnection.delete();
+      }
+    });
+
+    it('Should not wait for readers in truncating checkpoints', async () => {
+      const checkpointConnection = open('busy_checkpoints', {
+        backgroundCheckpoints: true,
+        busyTimeout: 1000
+      });
+      try {
+        await checkpointConnection.execute('CREATE TABLE IF NOT EXISTS Data (id INTEGER PRIMARY KEY, value TEXT)');
+        await checkpointConnection.execute('INSERT INTO Data (value) VALUES (?)', ['x']);
+
+        await checkpointConnection.readLock(async (tx) => {
+          // The open read transaction keeps using the WAL
+          await tx.execute('BEGIN');
+          await tx.execute('SELECT * FROM Data');
+
+          checkpointConnection.requestCheckpoint(true);
+          const start = Date.now();
+          await checkpointConnection.execute('INSERT INTO Data (value) VALUES (?)', ['y']);
+          expect(Date.now() - start).to.be.lessThan(500);
+
+          await tx.execute('COMMIT');
+        });
+
+        const stats = checkpointConnection.getCheckpointStats();
+        expect(stats.truncateCheckpoints).to.equal(1);
+        expect(stats.busyCheckpoints).to.equal(1);
+      } finally {
+        checkpointConnection.close();
+        checkpointConnection.delete();
+      }
+    });
+
+    it('Should restart parked read connection threads', async () => {
+      const parkedConnection = open('parked_read_threads', {
+        numReadConnections: 2,
+        readThreadIdleTimeoutMs: 10
+      });
+      try {
+        await parkedConnection.execute('CREATE TABLE IF NOT EXISTS Data (id INTEGER PRIMARY KEY, value TEXT)');
+        await parkedConnection.execute('INSERT INTO Data (value) VALUES (?)', ['parked']);
+        // Wait for the read threads to exit
+        await new Promise((resolve) => setTimeout(resolve, 100));
+
+        const results = await Promise.all(
+          [1, 2, 3].map(() => parkedConnection.readLock((tx) => tx.execute('SELECT value FROM Data')))
+        );
+        for (const result of results) {
+          expect(result.rows!.item(0).value).to.equal('parked');
+        }
+      } finally {
+        parkedConnection.close();
+        parkedConnection.delete();
+      }
+    });
+
+    it('Should reject queued statements when the db is closed', async () => {
+      const closingConnection = open('closing_requests', {
+        numReadConnections: 1
+      });
+      let release = () => {};
+      const held = closingConnection.writeLock(() => new Promise<void>((resolve) => (release = resolve)));
+      await new Promise((resolve) => setTimeout(resolve, 50));
+
+      // Waits natively for the write lock which is held by JS
+      const pending = closingConnection.execute('SELECT 1').catch((ex) => ex);
+      closingConnection.close();
+      const error = await pending;
+      expect(error).to.be.instanceOf(Error);
+      expect(error.message).to.include('closed');
+
+      release();
+      await held;
+      closingConnection.delete();
+    });
+
+    it('Should open read connections lazily', async () => {
+      const lazyConnection = open('lazy_read_connections', {
+        numReadConnections: 3,
+        lazyReadConnections: true
+      });
+      try {
+        expect(lazyConnection.getStats().read.length).to.equal(0);
+        await lazyConnection.execute('CREATE TABLE IF NOT EXISTS Data (id INTEGER PRIMARY KEY, value TEXT)');
+        await lazyConnection.execute('INSERT INTO Data (value) VALUES (?)', ['lazy']);
+
+        const results = await Promise.all(
+          [1, 2, 3].map(() =>
+            lazyConnection.readLock(async (tx) => {
+              // Hold the lock so the reads need separate connections
+              await new Promise((resolve) => setTimeout(resolve, 50));
+              return tx.execute('SELECT value FROM Data');
+            })
+          )
+        );
+        for (const result of results) {
+          expect(result.rows!.item(0).value).to.equal('lazy');
+        }
+        expect(lazyConnection.getStats().read.length).to.equal(3);
+
+        // Idle read connections are closed and opened again once needed
+        lazyConnection.releaseMemory();
+        expect(lazyConnection.getStats().read.length).to.equal(0);
+        const result = await lazyConnection.readLock((tx) => tx.execute('SELECT value FROM Data'));
+        expect(result.rows!.item(0).value).to.equal('lazy');
+      } finally {
+        lazyConnection.close();
+        lazyConnection.delete();
+      }
+    });
+
+    it('Should run connections on shared workers', async () => {
+      const sharedConnection = open('shared_workers', {
+        numReadConnections: 3,
+        sharedWorkers: true
+      });
+      try {
+        await sharedConnection.execute('CREATE TABLE IF NOT EXISTS Data (id INTEGER PRIMARY KEY, value TEXT)');
+        await sharedConnection.execute('DELETE FROM Data');
+
+        // Tasks of a connection keep their order on the shared threads
+        await Promise.all(
+          Array.from({ length: 20 }, (_, i) =>
+            sharedConnection.execute('INSERT INTO Data (id, value) VALUES (?, ?)', [i, 'shared'])
+          )
+        );
+        const results = await Promise.all(
+          [1, 2, 3].map(() =>
+            sharedConnection.readLock(async (tx) => {
+              await new Promise((resolve) => setTimeout(resolve, 50));
+              return tx.execute('SELECT id FROM Data ORDER BY id');
+            })
+          )
+        );
+        for (const result of results) {
+          expect(result.rows!._array.map((row) => row.id)).to.deep.equal(Array.from({ length: 20 }, (_, i) => i));
+        }
+      } finally {
+        sharedConnection.close();
+        sharedConnection.delete();
+      }
+    });
+
+    it('Should release locks with open cursors on shared workers', async () => {
+      const sharedConnection = open('shared_workers_cursors', {
+        numReadConnections: 3,
+        sharedWorkers: true
+      });
+      try {
+        await sharedConnection.execute('CREATE TABLE IF NOT EXISTS Data (id INTEGER PRIMARY KEY, value TEXT)');
+        await sharedConnection.execute('DELETE FROM Data');
+        await sharedConnection.executeBatch([
+          ['INSERT INTO Data (id, value) VALUES (?, ?)', Array.from({ length: 100 }, (_, i) => [i, 'shared'])]
+        ]);
+
+        // Releasing a lock with an open cursor queues work on its connection
+        // while native reads on the other connections release their locks.
+        const reads = Array.from({ length: 50 }, () =>
+          sharedConnection.executeRead('SELECT COUNT(*) as count FROM Data')
+        );
+        const cursors = Array.from({ length: 10 }, () =>
+          sharedConnection.readLock(async (tx) => {
+            const cursor = await tx.cursor('SELECT * FROM Data ORDER BY id', [], { chunkSize: 10 });
+            return (await cursor.next()).length;
+          })
+        );
+
+        for (const result of await Promise.all(reads)) {
+          expect(result.rows!.item(0).count).to.equal(100);
+        }
+        expect(await Promise.all(cursors)).to.deep.equal(new Array(10).fill(10));
+      } finally {
+        sharedConnection.close();
+        sharedConnection.delete();
+      }
+    });
+
+    it('Should backup the database', async () => {
+      await db.execute('CREATE TABLE IF NOT EXISTS Backup (id INTEGER PRIMARY KEY, value TEXT)');
+      await db.execute('DELETE FROM Backup');
+      for (let i = 0; i < 10; i++) {
+        await db.execute('INSERT INTO Backup (value) VALUES (?)', ['x'.repeat(4096)]);
+      }
+
+      const progress: BackupProgress[] = [];
+      const result = await db.backup('backup_copy', {
+        pagesPerStep: 1,
+        onProgress: (event) => progress.push(event)
+      });
+      expect(result.totalPages).to.be.greaterThan(10);
+      // Progress events are delivered before the result
+      expect(progress.length).to.be.greaterThan(1);
+      expect(progress[progress.length - 1].remainingPages).to.equal(0);
+
+      const backupConnection = open('backup_copy');
+      try {
+        const copied = await backupConnection.execute('SELECT count(*) AS count FROM Backup');
+        expect(copied.rows!.item(0).count).to.equal(10);
+      } finally {
+        backupConnection.close();
+        backupConnection.delete();
+      }
+    });
+
+    it('Should enforce query result limits', async () => {
+      await createTestUser();
+      await createTestUser();
+      await createTestUser();
+
+      let error: Error | undefined;
+      try {
+        await db.executeRead('SELECT * FROM User', [], { maxRows: 2 });
+      } catch (ex) {
+        error = ex as Error;
+      }
+      expect(error?.message).to.include('maxRows');
+
+      error = undefined;
+      try {
+        await db.readLock((context) => context.execute('SELECT randomblob(1000) FROM User', [], { maxBytes: 1500 }));
+      } catch (ex) {
+        error = ex as Error;
+      }
+      expect(error?.message).to.include('maxBytes');
+
+      const result = await db.executeRead('SELECT * FROM User', [], { maxRows: 3 });
+      expect(result.rows?.length).to.equal(3);
+    });
+
+    it('Should interrupt running statements of a lock', async () => {
+      await db.readLock(async (context) => {
+        const slowQuery = context.execute(
+          'WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 1000000000) SELECT count(*) FROM c'
+        );
+        await new Promise((resolve) => setTimeout(resolve, 100));
+        context.interrupt();
+
+        let error: Error | undefined;
+        try {
+          await slowQuery;
+        } catch (ex) {
+          error = ex as Error;
+        }
+        expect(error?.message).to.include('interrupted');
+
+        // Later statements are not interrupted
+        const result = await context.execute('SELECT 1 as value');
+        expect(result.rows?.item(0).value).to.equal(1);
+      });
+    });
+
+    it('Should search FTS5 tables by rank', async () => {
+      await db.execute('CREATE VIRTUAL TABLE messages USING fts5(title, body)');
+      await db.executeBatch([
+        [
+          'INSERT INTO messages (rowid, title, body) VALUES (?, ?, ?)',
+          [
+            [1, 'hello', 'the quick brown fox'],
+            [2, 'fox news', 'a fox and another fox'],
+            [3, 'other', 'nothing to see here']
+          ]
+        ]
+      ]);
+
+      const result = await db.search('messages', 'fox', {
+        columns: ['title'],
+        limit: 1,
+        snippet: { column: 1, start: '[', end: ']' }
+      });
+      expect(result.rows?._array).to.have.length(1);
+      const match = result.rows?.item(0);
+      expect(match.rowid).to.equal(2);
+      expect(match.title).to.equal('fox news');
+      expect(match.snippet).to.equal('a [fox] and another [fox]');
+      expect(match.rank).to.be.lessThan(0);
+
+      const all = await db.search('messages', 'fox');
+      expect(all.rows?._array.map((row) => row.rowid)).to.deep.equal([2, 1]);
+    });
+
+    it('Should record and apply changesets', async () => {
+      const session = await db.createSession(['User']);
+      const { id, name, age, networth } = generateUserInfo();
+      await db.execute('INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)', [id, name, age, networth]);
+      // Not recorded
+      await db.execute('INSERT INTO t1(a, b, c) VALUES(?, ?, ?)', [1, 2, 'c']);
+
+      const changeset = await session.changeset();
+      session.close();
+      expect(changeset.byteLength).to.be.greaterThan(0);
+
+      await db.execute('DELETE FROM User');
+      await db.execute('DELETE FROM t1');
+      const updates: BatchedUpdateNotification[] = [];
+      const stopListening = db.registerTablesChangedHook((update) => updates.push(update));
+      await db.applyChangeset(changeset);
+      stopListening();
+      // Reported once the changeset is applied, not with the next write lock
+      expect(updates.map((update) => update.tables)).to.deep.equal([['User']]);
+
+      const users = await db.execute('SELECT * FROM User');
+      expect(users.rows?._array).to.deep.equal([{ id, name, age, networth }]);
+      const others = await db.execute('SELECT * FROM t1');
+      expect(others.rows?.length).to.equal(0);
+    });
+
     it('Should open a db without concurrency', async () => {
       const singleConnection = open('single_connection', {
         numReadConnections: 0
@@ -558,6 +1359,22 @@ export function registerBaseTests() {
       expect(update.rawUpdates.length).to.equal(2);
     });
 
+    it('should not report table updates which are rolled back', async () => {
+      const updates: UpdateNotification[] = [];
+      db.registerUpdateHook((update) => updates.push(update));
+
+      await db.writeTransaction(async (tx) => {
+        await createTestUser(tx);
+        await tx.rollback();
+      });
+
+      const { id, name, age, networth } = generateUserInfo();
+      await db.execute('INSERT INTO "User" (id, name, age, networth) VALUES(?, ?, ?, ?)', [id, name, age, networth]);
+
+      expect(updates.length).to.equal(1);
+      expect(updates[0].rowId).to.be.a('number');
+    });
+
     it('Should reflect writeTransaction updates on read connections', async () => {
       const readTriggerCallbacks = [];
 
@@ -598,6 +1415,23 @@ export function registerBaseTests() {
       expect(resolved).to.deep.equal(readerPromises.map(() => numberOfUsers));
     });
 
+    it('Should reflect schema changes for repeated statements', async () => {
+      await db.execute('CREATE TABLE IF NOT EXISTS Cached (id INTEGER PRIMARY KEY, name TEXT)');
+      await db.execute('INSERT INTO Cached (id, name) VALUES (1, ?)', ['first']);
+
+      const before = await db.execute('SELECT * FROM Cached');
+      expect(before.rows?._array).to.eql([{ id: 1, name: 'first' }]);
+
+      await db.execute('DROP TABLE Cached');
+      await db.execute('CREATE TABLE Cached (id INTEGER PRIMARY KEY, name TEXT, age INTEGER)');
+      await db.execute('INSERT INTO Cached (id, name, age) VALUES (2, ?, ?)', ['second', 30]);
+
+      const after = await db.execute('SELECT * FROM Cached');
+      expect(after.rows?._array).to.eql([{ id: 2, name: 'second', age: 30 }]);
+
+      await db.execute('DROP TABLE Cached');
+    });
+
     it('Should attach DBs', async () => {
       const singleConnection = open('single_connection', {
         numReadConnections: 0
@@ -617,6 +1451,10 @@ export function registerBaseTests() {
       expect(result.rows?.length).to.equal(1);
     });
 
+    it('Should report failed detaches', async () => {
+      expect(() => db.detach('missing')).to.throw(/unable to detach another database/);
+    });
+
     it('10000 INSERTs', async () => {
       let start = performance.now();
       for (let i = 0; i < 1000; ++i) {